@@ -14,9 +14,12 @@
 #include <CryCore/StaticInstanceList.h>
 
 #include <DefaultComponents/Physics/RigidBodyComponent.h>
-#include <DefaultComponents/Geometry/StaticMeshComponent.h>
 #include <DefaultComponents/Input/InputComponent.h>
 
+#include "TickScheduler.h"
+#include "SolveCapture.h"
+#include "ViewScalePolicy.h"
+
 void Player::Initialize()
 {
 	m_character = m_pEntity->GetOrCreateComponent<Cry::DefaultComponents::CCharacterControllerComponent>();
@@ -27,6 +30,11 @@ void Player::Initialize()
 
 	m_character->SetTransformMatrix(Matrix34::Create(Vec3(1.f), IDENTITY, Vec3(0, 0, CHARACHTER_Z * m_scale)));
 
+	m_pEntity->GetNetEntity()->BindToNetwork();
+	// Both are handled after the state update they are sent with, which holds the player position and scale they rely on.
+	SRmi<RMI_WRAP(&Player::ClTeleport)>::Register(this, eRAT_PostAttach, false, eNRT_ReliableOrdered);
+	SRmi<RMI_WRAP(&Player::ClRelease)>::Register(this, eRAT_PostAttach, false, eNRT_ReliableOrdered);
+
 	m_input->RegisterAction("player", "moveleft", [this](int activationMode, float value) { HandleInputFlagChange(EInputFlag::MoveLeft, (EActionActivationMode)activationMode);  });
 	m_input->BindAction("player", "moveleft", eAID_KeyboardMouse, EKeyId::eKI_A);
 
@@ -39,10 +47,10 @@ void Player::Initialize()
 	m_input->RegisterAction("player", "moveback", [this](int activationMode, float value) { HandleInputFlagChange(EInputFlag::MoveBack, (EActionActivationMode)activationMode);  });
 	m_input->BindAction("player", "moveback", eAID_KeyboardMouse, EKeyId::eKI_S);
 
-	m_input->RegisterAction("player", "mouse_rotateyaw", [this](int activationMode, float value) { m_mouseDelta.x -= value; });
+	m_input->RegisterAction("player", "mouse_rotateyaw", [this](int activationMode, float value) { m_mouseDelta.x -= value; wake(); });
 	m_input->BindAction("player", "mouse_rotateyaw", eAID_KeyboardMouse, EKeyId::eKI_MouseX);
 
-	m_input->RegisterAction("player", "mouse_rotatepitch", [this](int activationMode, float value) { m_mouseDelta.y -= value; });
+	m_input->RegisterAction("player", "mouse_rotatepitch", [this](int activationMode, float value) { m_mouseDelta.y -= value; wake(); });
 	m_input->BindAction("player", "mouse_rotatepitch", eAID_KeyboardMouse, EKeyId::eKI_MouseY);
 
 	m_input->RegisterAction("player", "shoot", [this](int activationMode, float value) {
@@ -59,8 +67,10 @@ void Player::Initialize()
 	m_input->BindAction("player", "exit", eAID_KeyboardMouse, EKeyId::eKI_Escape);
 
 	m_input->RegisterAction("player", "toggle_debug", [this](int activationMode, float value) {
-		if (activationMode == eAAM_OnPress)
+		if (activationMode == eAAM_OnPress) {
 			m_debug ^= 1;
+			wake();
+		}
 	});
 	m_input->BindAction("player", "toggle_debug", eAID_KeyboardMouse, EKeyId::eKI_Tab);
 
@@ -72,31 +82,69 @@ void Player::Initialize()
 	m_input->BindAction("player", "jump", eAID_KeyboardMouse, EKeyId::eKI_Space);
 }
 
+void Player::OnShutDown()
+{
+	getTickScheduler().remove(this);
+	getViewScalePolicy().reset();
+}
+
 Cry::Entity::EventFlags Player::GetEventMask() const
 {
-	return Cry::Entity::EEvent::Update | Cry::Entity::EEvent::GameplayStarted;// | Cry::Entity::EEvent::PrePhysicsUpdate;
+	return Cry::Entity::EEvent::GameplayStarted;// | Cry::Entity::EEvent::PrePhysicsUpdate;
+}
+
+void Player::wake()
+{
+	getTickScheduler().players.wake(this);
+}
+
+bool Player::tick(float delta)
+{
+	// Remote copies only follow replicated state.
+	if (!isNetAuthority()) {
+		m_inputFlags = CEnumFlags<EInputFlag>();
+		m_mouseDelta = ZERO;
+	}
+
+	updateScale(delta);
+	getViewScalePolicy().update(m_scale);
+	updateNearPlane();
+	if (!isNetAuthority())
+		blendNetPosition(delta);
+	updateMovement(delta);
+	updateCamera(delta);
+	updateGrabbedObject(delta);
+
+	if (gEnv->bMultiplayer && gEnv->bServer)
+		syncNetState(false);
+
+	// Physics moves the entity and the camera with it, nothing here has work left without input.
+	const bool idle = !m_grabbedObject && !m_inputFlags && m_mouseDelta.IsZero() && m_scaleBlend >= 1.f
+		&& !m_shouldTeleport && !m_debug && !gEnv->bMultiplayer;
+
+	return !idle;
 }
 
 void Player::ProcessEvent(const SEntityEvent& event)
 {
 	switch (event.event)
 	{
-		case Cry::Entity::EEvent::Update:
-		{
-			const float delta = event.fParam[0];
-
-			updateMovement(delta);
-			updateCamera(delta);
-			updateGrabbedObject(delta);
-		}
-		break;
-
 		case Cry::Entity::EEvent::GameplayStarted:
 		{
 			m_camera->SetTransformMatrix(IDENTITY);
 			m_scale = m_start_scale;
 			//CryLogAlways("PLAYER GAMEPLAY STARTED!");
 			applyCharacterScale(1.f);
+
+			m_scaleFrom = m_scaleTarget = m_scale;
+			m_scaleBlend = 1.f;
+			if (m_nearPlaneBase <= 0.f)
+				m_nearPlaneBase = m_camera->GetNearPlane();
+			getViewScalePolicy().update(m_scale, true);
+			updateNearPlane();
+			Teleport::updateWakeAreas(m_scale);
+
+			wake();
 		}
 		break;
 	}
@@ -156,15 +204,23 @@ void Player::updateCamera(float delta)
 	m_camera->GetTransformMatrix().GetRotation33(camOrientation);
 	Ang3 ypr = CCamera::CreateAnglesYPR(camOrientation);
 
-	ypr.x += m_mouseDelta.x * rotationSpeed;
-	ypr.y = CLAMP(ypr.y + m_mouseDelta.y * rotationSpeed, rotationLimitsMinPitch, rotationLimitsMaxPitch);
+	if (isNetAuthority()) {
+		ypr.x += m_mouseDelta.x * rotationSpeed;
+		ypr.y = CLAMP(ypr.y + m_mouseDelta.y * rotationSpeed, rotationLimitsMinPitch, rotationLimitsMaxPitch);
+	}
+	else {
+		ypr.x = NetQuantize::unangle(m_netState.yaw);
+		ypr.y = NetQuantize::unangle(m_netState.pitch);
+	}
 	ypr.z = 0;
 
 	m_mouseDelta = ZERO;
+	m_viewAngles = ypr;
 
 	m_bodyOrientation = CCamera::CreateOrientationYPR(Ang3(ypr.x, 0, 0));
 
-	Matrix34 localTransform = m_character->GetTransformMatrix();
+	// Not read back from the character, which is only rebuilt by applyCharacterScale.
+	Matrix34 localTransform = Matrix34::Create(Vec3(1.f), IDENTITY, Vec3(0, 0, CHARACHTER_Z * m_scale));
 	camOrientation = CCamera::CreateOrientationYPR(ypr);
 	localTransform.SetRotation33(camOrientation);
 	localTransform.AddTranslation(Vec3(0, 0, cameraHeight * m_scale));
@@ -175,76 +231,159 @@ void Player::updateCamera(float delta)
 }
 
 void Player::lockLocalPoints() {
-	IPhysicalEntity* physEnt = m_grabbedObject->GetPhysics();
+	const GrabSamples& samples = getGrabSamples(m_grabbedObject);
 
-	pe_status_pos spos;
-	m_grabbedObject->GetPhysics()->GetStatus(&spos);
-	physEnt->GetStatus(&spos);
+	m_grabbedObjectPoints = samples.points;
+	m_grabbedPrimitives = samples.primitives;
+}
 
-	std::vector<Vec3>& points = m_grabbedObjectPoints;
-	IGeometry* geom = spos.pGeom;
+void Player::prefetchGrabSamples(IEntity* entity)
+{
+	getGrabSamples(entity);
+}
 
-	Cry::DefaultComponents::CStaticMeshComponent *mesh = m_grabbedObject->GetComponent<Cry::DefaultComponents::CStaticMeshComponent>();
+const Player::GrabSamples& Player::getGrabSamples(IEntity* entity)
+{
+	const size_t maxCachedSamples = 256;
 
-	Matrix34 localTransform = mesh ? mesh->GetTransformMatrix() : IDENTITY;
+	auto it = m_grabSampleCache.find(entity->GetId());
+	if (it != m_grabSampleCache.end() && it->second.physics == entity->GetPhysics())
+		return it->second;
 
-	if (geom->GetType() == GEOM_TRIMESH) {
-		points.clear();
+	if (m_grabSampleCache.size() >= maxCachedSamples)
+		m_grabSampleCache.clear();
 
-		const mesh_data* mesh = (mesh_data*) geom->GetData();
+	GrabSamples& samples = m_grabSampleCache[entity->GetId()];
+	buildGrabSamples(entity, samples);
+	return samples;
+}
 
-		for (int i = 0; i < mesh->nVertices; i++) {
-			points.push_back(localTransform * mesh->pVertices[i]);
-		}
-	}
-	
-	else {
-		const int SAMPLES = 4;
+void Player::buildGrabSamples(IEntity* entity, GrabSamples& samples) {
+	IPhysicalEntity* physEnt = entity->GetPhysics();
 
-		points.clear();
-		points.reserve(8 + SAMPLES * SAMPLES * 6);
+	std::vector<Vec3>& points = samples.points;
+	points.clear();
+	samples.primitives.clear();
+	samples.physics = physEnt;
 
-		primitives::box box;
-		geom->GetBBox(&box);
+	if (!physEnt)
+		return;
 
-		//CryLogAlways("BOX POSITION %f %f %f", box.center.x, box.center.y, box.center.z);
+	pe_status_pos spos;
+	physEnt->GetStatus(&spos);
+
+	// Parts are posed relative to the physical entity, points are kept relative to the entity.
+	const Matrix34 entityFromPhys = entity->GetWorldTM().GetInverted() * Matrix34::Create(Vec3(1.f), spos.q, spos.pos);
+
+	auto addBoxCorners = [&points](const Matrix34& tm, const primitives::box& box) {
+		const Matrix33 axes = box.Basis.GetTransposed();
 
 		for (int i = 0; i < 8; i++) {
 			float sx = (float)((i & 1) * 2 - 1);
 			float sy = (float)((i >> 1 & 1) * 2 - 1);
 			float sz = (float)((i >> 2 & 1) * 2 - 1);
 
-			//CryLogAlways("i = %d %d %d %d", i, sx, sy, sz);
-			points.push_back(Vec3(sx, sy, sz).CompMul(box.size));
+			points.push_back(tm * (box.center + axes * Vec3(sx, sy, sz).CompMul(box.size)));
 		}
+	};
 
-		std::vector<std::array<Vec3, 3>> faces = {
-			{points[0], points[1], points[2]},
-			{points[0], points[1], points[4]},
-			{points[0], points[2], points[4]},
+	pe_status_nparts nparts;
+	const int partCount = physEnt->GetStatus(&nparts);
 
-			{points[1], points[3], points[5]},
-			{points[2], points[3], points[6]},
-			{points[4], points[5], points[6]},
-		};
+	for (int ipart = 0; ipart < partCount; ipart++) {
+		pe_params_part part;
+		part.ipart = ipart;
 
+		if (!physEnt->GetParams(&part) || !part.pPhysGeom || !part.pPhysGeom->pGeom)
+			continue;
 
-		for (const auto& face : faces) {
-			Vec3 diff_i = (face[1] - face[0]);
-			Vec3 diff_j = (face[2] - face[0]);
+		IGeometry* geom = part.pPhysGeom->pGeom;
+		const Matrix34 tm = entityFromPhys * Matrix34::Create(Vec3(part.scale), part.q, part.pos);
 
-			for (int i = 1; i < SAMPLES + 1; i++) {
-				for (int j = 1; j < SAMPLES + 1; j++) {
-					float fi = i / (float)(SAMPLES + 1);
-					float fj = j / (float)(SAMPLES + 1);
+		switch (geom->GetType()) {
+			// Walls are planar enough that polyhedra first touch them with a vertex.
+			case GEOM_TRIMESH:
+			{
+				const mesh_data* mesh = (mesh_data*) geom->GetData();
 
-					points.push_back(face[0] + diff_i * fi + diff_j * fj);
+				for (int i = 0; i < mesh->nVertices; i++) {
+					points.push_back(tm * mesh->pVertices[i]);
 				}
 			}
+			break;
+
+			case GEOM_BOX:
+			{
+				addBoxCorners(tm, *(const primitives::box*) geom->GetData());
+			}
+			break;
+
+			// Curved primitives are kept whole, their support points depend on the wall they face.
+			case GEOM_SPHERE:
+			{
+				const primitives::sphere* sphere = (const primitives::sphere*) geom->GetData();
+
+				GrabbedPrimitive prim;
+				prim.type = GEOM_SPHERE;
+				prim.tm = tm;
+				prim.center = sphere->center;
+				prim.r = sphere->r;
+				samples.primitives.push_back(prim);
+			}
+			break;
+
+			case GEOM_CAPSULE:
+			case GEOM_CYLINDER:
+			{
+				const primitives::cylinder* cylinder = (const primitives::cylinder*) geom->GetData();
+
+				GrabbedPrimitive prim;
+				prim.type = geom->GetType();
+				prim.tm = tm;
+				prim.center = cylinder->center;
+				prim.axis = cylinder->axis;
+				prim.r = cylinder->r;
+				prim.hh = cylinder->hh;
+				samples.primitives.push_back(prim);
+			}
+			break;
+
+			default:
+			{
+				primitives::box box;
+				geom->GetBBox(&box);
+				addBoxCorners(tm, box);
+			}
+			break;
 		}
 	}
 }
 
+Vec3 Player::supportPoint(const GrabbedPrimitive& prim, const Matrix34& worldTM, const Vec3& dir)
+{
+	const Matrix34 tm = worldTM * prim.tm;
+	const float scale = tm.GetColumn0().GetLength();
+
+	Vec3 d = dir.GetNormalized();
+	Vec3 center = tm * prim.center;
+
+	if (prim.type == GEOM_SPHERE)
+		return center + d * prim.r * scale;
+
+	Vec3 axis = tm.TransformVector(prim.axis).GetNormalized();
+	Vec3 cap = center + axis * (d.dot(axis) >= 0 ? prim.hh * scale : -prim.hh * scale);
+
+	if (prim.type == GEOM_CAPSULE)
+		return cap + d * prim.r * scale;
+
+	// Cylinder: the point of the cap rim furthest along dir.
+	Vec3 radial = d - axis * d.dot(axis);
+	if (radial.GetLengthSquared() < 1e-8f)
+		return cap;
+
+	return cap + radial.GetNormalized() * prim.r * scale;
+}
+
 void Player::updateGrabbedObject(float delta)
 {
 	if (!m_grabbedObject)
@@ -253,7 +392,19 @@ void Player::updateGrabbedObject(float delta)
 	Vec3 origin = m_camera->GetWorldTransformMatrix().GetTranslation();
 	Vec3 newPos = origin + m_cameraViewDir * GRAB_OBJECT_DIST;
 
-	m_grabbedObject->SetPos(newPos);
+	IPhysicalEntity* physEnt = m_grabbedObject->GetPhysics();
+
+	if (m_sweepGrabbedObject && physEnt && !m_snapGrabbedObject && delta > 0) {
+		// Driven by velocity so the solver stops the body at walls.
+		pe_action_set_velocity drive;
+		drive.v = (newPos - m_grabbedObject->GetWorldPos()) / delta;
+		drive.w = ZERO;
+		physEnt->Action(&drive);
+	}
+	else {
+		m_grabbedObject->SetPos(newPos);
+		m_snapGrabbedObject = false;
+	}
 
 	if (m_debug) {
 		IPersistantDebug* db = gEnv->pGameFramework->GetIPersistantDebug();
@@ -264,54 +415,168 @@ void Player::updateGrabbedObject(float delta)
 	}
 }
 
+void Player::holdGrabbedPhysics(bool hold)
+{
+	IPhysicalEntity* physEnt = m_grabbedObject->GetPhysics();
+	if (!physEnt)
+		return;
+
+	pe_status_nparts nparts;
+	const int partCount = physEnt->GetStatus(&nparts);
+
+	if (hold) {
+		// The player never collides with a held body; walls only do when sweeping.
+		const unsigned int heldFlags = m_sweepGrabbedObject
+			? ~(unsigned int)(geom_colltype_player | geom_colltype_ray)
+			: ~(unsigned int)(geom_collides | geom_floats);
+
+		m_heldBody.partFlags.resize(partCount);
+
+		for (int i = 0; i < partCount; i++) {
+			pe_params_part part;
+			part.ipart = i;
+			physEnt->GetParams(&part);
+			m_heldBody.partFlags[i] = part.flagsOR;
+
+			pe_params_part held;
+			held.ipart = i;
+			held.flagsAND = heldFlags;
+			physEnt->SetParams(&held);
+		}
+
+		pe_simulation_params sim;
+		physEnt->GetParams(&sim);
+		m_heldBody.gravity = sim.gravity;
+		m_heldBody.gravityFreefall = sim.gravityFreefall;
+
+		pe_simulation_params weightless;
+		weightless.gravity = ZERO;
+		weightless.gravityFreefall = ZERO;
+		physEnt->SetParams(&weightless);
+	}
+
+	else {
+		for (int i = 0; i < partCount && i < (int)m_heldBody.partFlags.size(); i++) {
+			pe_params_part part;
+			part.ipart = i;
+			part.flagsAND = part.flagsOR = m_heldBody.partFlags[i];
+			physEnt->SetParams(&part);
+		}
+
+		pe_simulation_params sim;
+		sim.gravity = m_heldBody.gravity;
+		sim.gravityFreefall = m_heldBody.gravityFreefall;
+		physEnt->SetParams(&sim);
+	}
+
+	pe_action_set_velocity stop;
+	stop.v = ZERO;
+	stop.w = ZERO;
+	physEnt->Action(&stop);
+
+	pe_action_awake awake;
+	physEnt->Action(&awake);
+}
+
 void Player::doPerspectiveScaling() {
 	const float maxDist = 150;
 	const float wallMargin = 0.05f;
 
+	// The solve assumes the object at the hold point, a sweeping object may have been stopped short of it.
+	m_grabbedObject->SetPos(m_camera->GetWorldTransformMatrix().GetTranslation() + m_cameraViewDir * GRAB_OBJECT_DIST);
+
+	const Matrix34 worldTM = m_grabbedObject->GetWorldTM();
+
 	std::vector<Vec3> points = m_grabbedObjectPoints;
 	for (auto& point : points) {
-		point = m_grabbedObject->GetWorldTM() * point;
+		point = worldTM * point;
 	}
 
-	Vec3 origin = m_camera->GetWorldTransformMatrix().GetTranslation();
-	ray_hit hit;
-	
-	float minQ = 0;
-	float minDist = 2 * maxDist;
-	int minRay = -1;
+	const Matrix34 camTM = m_camera->GetWorldTransformMatrix();
+	Vec3 origin = camTM.GetTranslation();
 
-	for (size_t i = 0; i < points.size(); i++) {
+	// Curved primitives are first probed at their extremes along the camera axes.
+	const Vec3 probeDirs[] = { camTM.GetColumn0(), -camTM.GetColumn0(), camTM.GetColumn1(), -camTM.GetColumn1(), camTM.GetColumn2(), -camTM.GetColumn2() };
+
+	for (const GrabbedPrimitive& prim : m_grabbedPrimitives) {
+		for (const Vec3& probeDir : probeDirs) {
+			points.push_back(supportPoint(prim, worldTM, probeDir));
+		}
+	}
+
+	PortalRayHit result;
+
+	auto toFloat3 = [](const Vec3& v) { return PerspectiveSolve::Float3{ v.x, v.y, v.z }; };
+
+	std::vector<PerspectiveSolve::Ray> rays;
+	std::vector<Vec3> normals; // wall normals met so far, un-rotated by the portal angle into world space on the camera side
+
+	const CTimeValue castStart = gEnv->pTimer->GetAsyncTime();
+
+	auto castPoint = [&](size_t i) {
 		Vec3 dir = points[i] - origin;
 		float ln = dir.len();
 		dir = dir / ln * maxDist;
 
-		//if (ln > GRAB_OBJECT_DIST) 
+		rayCastFromCamera(result, dir, ent_all);
+
+		PerspectiveSolve::Ray ray = { toFloat3(points[i]), result.dist, 0 };
+
+		if (!result.hit.pCollider) {
+			rays.push_back(ray);
+			return;
+		}
+
+		ray.flags = PerspectiveSolve::RAY_HIT | (uint32)result.hops << 8;
+		rays.push_back(ray);
+
+		Vec3 normal = result.hit.n.GetRotated(Vec3(0, 0, 1), -result.transform.angle);
+		if (std::none_of(normals.begin(), normals.end(), [&normal](const Vec3& n) { return n.dot(normal) > 0.99f; }))
+			normals.push_back(normal);
+
+		if (m_debug)
 		{
-			rayCastFromCamera(hit, dir, ent_all);
+			IPersistantDebug* db = gEnv->pGameFramework->GetIPersistantDebug();
+			db->Begin("scale", false);
+			// Drawn unfolded: hits behind portals show up where they appear from the camera.
+			Vec3 hitPt = origin + dir.GetNormalized() * result.dist;
+			db->AddLine(points[i], hitPt, ColorF(0.5, 0.5, 0.5), 40.f);
+			db->AddSphere(Vec3::CreateLerp(points[i], hitPt, 0.5), 0.05, ColorF(0, 0, 0), 40);
+		}
+	};
 
-			if (!hit.pCollider)
-				continue;
-			
-			float hit_dist = std::max(hit.dist - wallMargin, 0.f);
+	for (size_t i = 0; i < points.size(); i++) {
+		castPoint(i);
+	}
 
-			float q = (hit_dist - ln) / ln;
+	// A curved primitive grows into a wall at its support point against the wall normal.
+	if (!m_grabbedPrimitives.empty()) {
+		const size_t probed = points.size();
 
-			if (minRay == -1 || q < minQ) {
-				minDist = hit_dist;
-				minQ = q;
-				minRay = i;
+		for (const Vec3& normal : normals) {
+			for (const GrabbedPrimitive& prim : m_grabbedPrimitives) {
+				points.push_back(supportPoint(prim, worldTM, -normal));
 			}
+		}
 
-			if (m_debug)
-			{
-				IPersistantDebug* db = gEnv->pGameFramework->GetIPersistantDebug();
-				db->Begin("scale", false);
-				db->AddLine(points[i], hit.pt, ColorF(0.5, 0.5, 0.5), 40.f);
-				db->AddSphere(Vec3::CreateLerp(points[i], hit.pt, 0.5), 0.05, ColorF(0, 0, 0), 40);
-			}
+		for (size_t i = probed; i < points.size(); i++) {
+			castPoint(i);
 		}
 	}
 	
+	PerspectiveSolve::RecordHeader record;
+	record.rayCount = (uint32)rays.size();
+	record.input = { toFloat3(origin), toFloat3(m_cameraViewDir), GRAB_OBJECT_DIST, wallMargin };
+	record.castMs = (gEnv->pTimer->GetAsyncTime() - castStart).GetMilliSeconds();
+	record.result = PerspectiveSolve::solve(record.input, rays.data(), rays.size());
+
+	if (getSolveCapture().enabled())
+		getSolveCapture().write(record, rays.data());
+
+	const int minRay = record.result.minRay;
+	const float minDist = record.result.minDist;
+	const float k = record.result.k;
+
 	if (minRay == -1) {
 		Vec3 newPos = origin + m_cameraViewDir * (GRAB_OBJECT_DIST + wallMargin);
 
@@ -327,10 +592,6 @@ void Player::doPerspectiveScaling() {
 	float newP = oldP * minDist / old_ln;
 
 	float d1 = GRAB_OBJECT_DIST;
-	float f = newP;
-	float d2 = f / (1 + (oldP - d1) / d1);
-
-	float k = d2 / d1;
 
 	Vec3 newPos = origin + m_cameraViewDir * d1 * k;
 
@@ -345,21 +606,31 @@ void Player::doPerspectiveScaling() {
 		db->AddSphere(origin + dir * minDist, 0.05f, ColorF(0, 0, 0), 40.0);
 	}
 
-	m_grabbedObject->SetPos(newPos);
-	m_grabbedObject->SetScale(k * m_grabbedObject->GetScale());
+	// Carry the object through the portals between the camera and its new position.
+	PortalRayHit placement;
+	rayCastFromCamera(placement, newPos - origin, ent_all);
+	const PortalTransform& transit = placement.transform;
+
+	m_grabbedObject->SetPos(transit.tm * newPos);
+	m_grabbedObject->SetRotation(Quat::CreateRotationZ(transit.angle) * m_grabbedObject->GetRotation());
+	m_grabbedObject->SetScale(k * transit.scale * m_grabbedObject->GetScale());
 }
 
 void Player::pickObject() {
 	const float volumeThreshold = 40.f;
 	const float pickRange = 150.f;
 
+	if (!isNetAuthority())
+		return;
+
+	wake();
+
 	if (m_grabbedObject == nullptr) {
-		ray_hit hit;
-		rayCastFromCamera(hit, m_cameraViewDir * pickRange, ent_rigid | ent_sleeping_rigid);
+		// Static geometry is included so portals can be followed; it also blocks the pick.
+		PortalRayHit result;
+		IEntity* entity = rayCastFromCamera(result, m_cameraViewDir * pickRange, ent_static | ent_rigid | ent_sleeping_rigid);
 
-		if (hit.pCollider) {
-			IEntity* entity = gEnv->pEntitySystem->GetEntityFromPhysics(hit.pCollider);
-			
+		if (entity && result.hit.pCollider->GetType() == PE_RIGID) {
 			AABB aabb;
 			entity->GetWorldBounds(aabb);
 
@@ -367,54 +638,100 @@ void Player::pickObject() {
 
 			m_grabbedObject = entity;
 		
-			m_grabbedObject->EnablePhysics(false);
+			holdGrabbedPhysics(true);
 			lockLocalPoints();
 
+			// Placed at the hold point on the first frame, sweeping from where it was picked would fly it there.
+			m_snapGrabbedObject = true;
+
+			// An object seen through portals is brought back into the camera space.
+			const PortalTransform& transit = result.transform;
+			Vec3 pos = transit.tm.GetInverted() * m_grabbedObject->GetPos();
+			m_grabbedObject->SetPos(pos);
+			m_grabbedObject->SetRotation(Quat::CreateRotationZ(-transit.angle) * m_grabbedObject->GetRotation());
+
 			//float dist = hit.dist;
-			float dist = (m_grabbedObject->GetPos() - m_camera->GetWorldTransformMatrix().GetTranslation()).len();
-			float k = GRAB_OBJECT_DIST / dist;
+			float dist = (pos - m_camera->GetWorldTransformMatrix().GetTranslation()).len();
+			float k = GRAB_OBJECT_DIST / dist / transit.scale;
 
 			m_grabbedObject->SetScale(m_grabbedObject->GetScale() * k);
 		}
 	}
 
 	else {
-		m_grabbedObject->EnablePhysics(true);
-
-		IPhysicalEntity* physEnt = m_grabbedObject->GetPhysics();
-		pe_action_reset reset = pe_action_reset();
-		physEnt->Action(&reset);
-		pe_action_awake awake = pe_action_awake();
-		physEnt->Action(&awake);
-
 		doPerspectiveScaling();
+		holdGrabbedPhysics(false);
+		replicateRelease();
 
 		m_grabbedObject = nullptr;
 	}
 }
 
-IEntity* Player::rayCastFromCamera(ray_hit &hit, const Vec3 &dir, int objTypes) {
+IEntity* Player::rayCastFromCamera(PortalRayHit &result, const Vec3 &dir, int objTypes) {
 	Vec3 origin = m_camera->GetWorldTransformMatrix().GetTranslation();
-	
+
+	return rayCastThroughPortals(result, origin, dir, objTypes);
+}
+
+IEntity* Player::rayCastThroughPortals(PortalRayHit &result, const Vec3 &origin, const Vec3 &dir, int objTypes) {
 	const unsigned int flags = rwi_stop_at_pierceable | rwi_colltype_any;
 
-	IPhysicalEntity* skip = m_character->GetEntity()->GetPhysics();
+	// The last slot holds the gateway the ray has just come out of.
+	IPhysicalEntity* skip[3] = { m_character->GetEntity()->GetPhysics(), nullptr, nullptr };
+	int skipCount = 1;
 
-	gEnv->pPhysicalWorld->RayWorldIntersection(origin, dir, objTypes, flags, &hit, 1, skip);
+	if (m_grabbedObject && m_grabbedObject->GetPhysics())
+		skip[skipCount++] = m_grabbedObject->GetPhysics();
 
+	const int fixedSkipCount = skipCount;
 
-	if (hit.pCollider) {
-		if (m_debug) {
-			IPersistantDebug* db = gEnv->pGameFramework->GetIPersistantDebug();
-			db->Begin("RC hit", false);
-			db->AddSphere(hit.pt, 0.05f, ColorF(0, 0, 1), 40.0);
+	result = PortalRayHit();
+
+	Vec3 segOrigin = origin;
+	Vec3 segDir = dir;
+
+	while (true) {
+		ray_hit& hit = result.hit;
+		hit.pCollider = nullptr;
+
+		int count = gEnv->pPhysicalWorld->RayWorldIntersection(segOrigin, segDir, objTypes, flags, &hit, 1, skip, skipCount);
+
+		if (count == 0 || !hit.pCollider) {
+			hit.pCollider = nullptr;
+			return nullptr;
+		}
+
+		float travelled = result.dist;
+		result.dist = travelled + hit.dist / result.transform.scale;
+
+		IEntity* entity = gEnv->pEntitySystem->GetEntityFromPhysics(hit.pCollider);
+		Teleport* portal = entity ? entity->GetComponent<Teleport>() : nullptr;
+
+		float segLen = segDir.len();
+		float remaining = segLen - hit.dist;
+
+		if (!portal || !portal->getGateway() || result.hops >= MAX_PORTAL_HOPS || remaining <= 0) {
+			if (m_debug) {
+				IPersistantDebug* db = gEnv->pGameFramework->GetIPersistantDebug();
+				db->Begin("RC hit", false);
+				db->AddSphere(hit.pt, 0.05f, ColorF(0, 0, 1), 40.0);
+			}
+
+			return entity;
 		}
 
-		IPhysicalEntity* physEnt = hit.pCollider;
-		IEntity* entity = gEnv->pEntitySystem->GetEntityFromPhysics(physEnt);
-		return entity;
+		// Continue from the gateway with the remaining length in its units.
+		const PortalTransform& link = portal->getPortalTransform();
+
+		segOrigin = link.tm * hit.pt;
+		segDir = link.transformDir(segDir / segLen) * remaining * link.scale;
+
+		result.transform.append(link);
+		result.hops++;
+
+		skip[fixedSkipCount] = portal->getGateway()->GetPhysics();
+		skipCount = skip[fixedSkipCount] ? fixedSkipCount + 1 : fixedSkipCount;
 	}
-	return nullptr;
 }
 
 void Player::applyCharacterScale(float scale)
@@ -435,13 +752,113 @@ void Player::applyCharacterScale(float scale)
 	//}
 }
 
+void Player::updateNearPlane()
+{
+	if (m_nearPlaneBase <= 0.f)
+		return;
+
+	const float nearPlane = getViewScalePolicy().nearPlane(m_nearPlaneBase);
+	if (nearPlane != m_camera->GetNearPlane())
+		m_camera->SetNearPlane(nearPlane);
+}
+
+void Player::updateScale(float delta)
+{
+	if (m_scaleBlend >= 1.f)
+		return;
+
+	// Shrinking always fits, only growing is spread over several frames.
+	float blend = m_scaleTarget < m_scale ? 1.f : std::min(m_scaleBlend + delta / SCALE_BLEND_TIME, 1.f);
+	float scale = m_scaleFrom * pow(m_scaleTarget / m_scaleFrom, blend);
+
+	// A blocked step is retried next frame instead of pushing the player out of the geometry.
+	if (resizeCharacter(scale)) {
+		m_scaleBlend = blend;
+
+		// Faster and slower players need earlier and later portal wake ups.
+		if (m_scaleBlend >= 1.f)
+			Teleport::updateWakeAreas(m_scale);
+	}
+}
+
+bool Player::resizeCharacter(float scale)
+{
+	IPhysicalEntity* physEnt = m_pEntity->GetPhysics();
+
+	pe_player_dimensions dims;
+	if (!physEnt || physEnt->GetType() != PE_LIVING || !physEnt->GetParams(&dims)) {
+		applyCharacterScale(scale / m_scale);
+		return true;
+	}
+
+	const float ratio = scale / m_scale;
+
+	if (ratio > 1.f) {
+		primitives::capsule prim;
+		prim.axis = Vec3(0, 0, 1);
+		prim.r = dims.sizeCollider.x * ratio;
+		prim.hh = dims.sizeCollider.z * ratio;
+		prim.center = m_pEntity->GetWorldPos() + Vec3(0, 0, dims.heightCollider * ratio);
+
+		// The held object sits inside the grown capsule and may still collide in sweep mode.
+		IPhysicalEntity* skip[2] = { physEnt, nullptr };
+		int skipCount = 1;
+		if (m_grabbedObject && m_grabbedObject->GetPhysics())
+			skip[skipCount++] = m_grabbedObject->GetPhysics();
+
+		geom_contact* contacts = nullptr;
+
+		IPhysicalWorld::SPWIParams pwi;
+		pwi.itype = dims.bUseCapsule ? primitives::capsule::type : primitives::cylinder::type;
+		pwi.pprim = &prim;
+		pwi.entTypes = ent_static | ent_terrain | ent_rigid | ent_sleeping_rigid;
+		pwi.ppcontact = &contacts;
+		pwi.pSkipEnts = skip;
+		pwi.nSkipEnts = skipCount;
+
+		if (gEnv->pPhysicalWorld->PrimitiveWorldIntersection(pwi) > 0)
+			return false;
+	}
+
+	pe_player_dimensions resized;
+	resized.sizeCollider = dims.sizeCollider * ratio;
+	resized.heightCollider = dims.heightCollider * ratio;
+	resized.heightPivot = dims.heightPivot * ratio;
+	resized.heightEye = dims.heightEye * ratio;
+	resized.heightHead = dims.heightHead * ratio;
+
+	if (!physEnt->SetParams(&resized))
+		return false;
+
+	m_scale = scale;
+
+	// Kept in sync for the next full physicalization, which takes the collider height from the transform.
+	m_character->SetTransformMatrix(Matrix34::Create(Vec3(1.f), IDENTITY, Vec3(0, 0, CHARACHTER_Z * m_scale)));
+	auto& params = m_character->GetPhysicsParameters();
+	params.m_height = CHARACHTER_HEIGHT * m_scale;
+	params.m_radius = CHARACHTER_RADIUS * m_scale;
+
+	return true;
+}
+
 void Player::teleport(Vec3 to, float zAng, float scale)
+{
+	m_pEntity->SetPos(to);
+
+	m_scaleFrom = m_scale;
+	m_scaleTarget *= scale;
+	m_scaleBlend = 0.f;
+	updateScale(0.f);
+
+	applyTransit(zAng, scale);
+}
+
+void Player::applyTransit(float zAng, float scale)
 {
 	m_shouldTeleport = true;
 	m_teleportVelocity = m_character->GetVelocity().GetRotated(Vec3(0, 0, 1), zAng) * scale;
 
-	m_pEntity->SetPos(to);
-	applyCharacterScale(scale);
+	wake();
 
 	Matrix34 rot = IDENTITY;
 	rot.SetRotationZ(zAng);
@@ -450,6 +867,7 @@ void Player::teleport(Vec3 to, float zAng, float scale)
 
 	if (m_grabbedObject) {
 		m_grabbedObject->SetRotation(Quat(rot) * m_grabbedObject->GetRotation());
+		m_snapGrabbedObject = true;
 	}
 }
 
@@ -458,8 +876,267 @@ float Player::getScale()
 	return m_scale;
 }
 
+bool Player::isNetAuthority() const
+{
+	return !gEnv->bMultiplayer || gEnv->bServer;
+}
+
+void Player::NetState::SerializeWith(TSerialize ser)
+{
+	ser.Value("base", baseSeq);
+	ser.Value("x", offset[0]);
+	ser.Value("y", offset[1]);
+	ser.Value("z", offset[2]);
+	ser.Value("yaw", yaw);
+	ser.Value("pitch", pitch);
+	ser.Value("scale", scale);
+	ser.Value("grabbed", grabbedId, 'eid');
+	ser.Value("grabbedScale", grabbedScale);
+	grabbedRotation.SerializeWith(ser);
+}
+
+bool Player::NetState::operator==(const NetState& other) const
+{
+	return baseSeq == other.baseSeq && offset[0] == other.offset[0] && offset[1] == other.offset[1] && offset[2] == other.offset[2] && yaw == other.yaw && pitch == other.pitch && scale == other.scale
+		&& grabbedId == other.grabbedId && grabbedScale == other.grabbedScale && grabbedRotation == other.grabbedRotation;
+}
+
+void Player::ReleaseParams::SerializeWith(TSerialize ser)
+{
+	ser.Value("object", objectId, 'eid');
+	ser.Value("absolute", absolute, 'bool');
+
+	if (absolute) {
+		ser.Value("pos", pos, 'wrld');
+	}
+	else {
+		ser.Value("x", offset[0]);
+		ser.Value("y", offset[1]);
+		ser.Value("z", offset[2]);
+	}
+
+	rotation.SerializeWith(ser);
+	ser.Value("scale", scale);
+}
+
+Player::NetState Player::captureNetState() const
+{
+	NetState state;
+	const Vec3 offset = m_pEntity->GetWorldPos() - m_netBase.pos;
+	state.baseSeq = m_netBase.seq;
+	for (int i = 0; i < 3; i++)
+		state.offset[i] = NetQuantize::offset(offset[i]);
+	state.yaw = NetQuantize::angle(m_viewAngles.x);
+	state.pitch = NetQuantize::angle(m_viewAngles.y);
+	state.scale = NetQuantize::scale(m_scaleTarget);
+
+	if (m_grabbedObject) {
+		state.grabbedId = m_grabbedObject->GetId();
+		state.grabbedScale = NetQuantize::scale(m_grabbedObject->GetScale().x);
+		state.grabbedRotation = NetQuantize::rotation(Quat::CreateRotationZ(-m_viewAngles.x) * m_grabbedObject->GetRotation());
+	}
+	return state;
+}
+
+void Player::applyNetState(const NetState& state)
+{
+	m_netState = state;
+	wake();
+	applyNetPosition();
+
+	float scale = NetQuantize::unscale(state.scale);
+	if (fabsf(scale / m_scaleTarget - 1.f) > 0.001f) {
+		m_scaleFrom = m_scale;
+		m_scaleTarget = scale;
+		m_scaleBlend = 0.f;
+	}
+
+	IEntity* grabbed = gEnv->pEntitySystem->GetEntity(state.grabbedId);
+	if (grabbed != m_grabbedObject) {
+		if (m_grabbedObject)
+			holdGrabbedPhysics(false);
+
+		m_grabbedObject = grabbed;
+
+		if (m_grabbedObject)
+			holdGrabbedPhysics(true);
+	}
+
+	if (m_grabbedObject) {
+		Quat rotation = Quat::CreateRotationZ(NetQuantize::unangle(state.yaw)) * NetQuantize::unrotation(state.grabbedRotation);
+		m_grabbedObject->SetRotation(rotation);
+		m_grabbedObject->SetScale(Vec3(NetQuantize::unscale(state.grabbedScale)));
+	}
+}
+
+Vec3 Player::netPosition() const
+{
+	return m_netBase.pos + Vec3(NetQuantize::unoffset(m_netState.offset[0]), NetQuantize::unoffset(m_netState.offset[1]), NetQuantize::unoffset(m_netState.offset[2]));
+}
+
+void Player::applyNetPosition()
+{
+	// The base travels in its own aspect and may arrive after the state that already uses it.
+	if (m_netState.baseSeq != m_netBase.seq)
+		return;
+
+	m_netTargetPos = netPosition();
+	m_netHasTarget = true;
+}
+
+void Player::blendNetPosition(float delta)
+{
+	if (!m_netHasTarget)
+		return;
+
+	// The local living entity keeps simulating between updates, snapping to each one shows as jitter.
+	const Vec3 pos = m_pEntity->GetWorldPos();
+	if (pos.GetDistance(m_netTargetPos) > NET_SNAP_DIST * m_scale)
+		m_pEntity->SetPos(m_netTargetPos);
+	else
+		m_pEntity->SetPos(Vec3::CreateLerp(pos, m_netTargetPos, 1.f - expf(-NET_BLEND_RATE * delta)));
+}
+
+bool Player::NetSerialize(TSerialize ser, EEntityAspects aspect, uint8 profile, int flags)
+{
+	if (aspect == BASE_ASPECT) {
+		NetBase base = m_netBase;
+		base.SerializeWith(ser);
+
+		if (ser.IsReading()) {
+			m_netBase = base;
+			applyNetPosition();
+			getNetStats().base.add(NetBase::PAYLOAD_BYTES);
+		}
+	}
+
+	if (aspect == STATE_ASPECT) {
+		NetState state = m_netState;
+		state.SerializeWith(ser);
+
+		// Also called for reasons other than a received update, the sender counts in syncNetState.
+		if (ser.IsReading()) {
+			applyNetState(state);
+			getNetStats().state.add(NetState::PAYLOAD_BYTES);
+		}
+	}
+	return true;
+}
+
+void Player::syncNetState(bool force)
+{
+	// Rebased with some slack before the offsets would clamp.
+	const float range = 30000 * NetQuantize::OFFSET_STEP;
+	const Vec3 offset = m_pEntity->GetWorldPos() - m_netBase.pos;
+	if (fabsf(offset.x) > range || fabsf(offset.y) > range || fabsf(offset.z) > range) {
+		m_netBase.pos = m_pEntity->GetWorldPos();
+		m_netBase.seq++;
+		NetMarkAspectsDirty(BASE_ASPECT);
+		getNetStats().base.add(NetBase::PAYLOAD_BYTES);
+	}
+
+	NetState state = captureNetState();
+	if (!force && state == m_netState)
+		return;
+
+	m_netState = state;
+	NetMarkAspectsDirty(STATE_ASPECT);
+	getNetStats().state.add(NetState::PAYLOAD_BYTES);
+}
+
+void Player::replicateTeleport(EntityId portalId)
+{
+	if (!gEnv->bMultiplayer || !gEnv->bServer)
+		return;
+
+	// The RMI is attached to this update, which carries the position and scale past the portal.
+	syncNetState(true);
+
+	TeleportParams params;
+	params.portalId = portalId;
+
+	SRmi<RMI_WRAP(&Player::ClTeleport)>::InvokeOnAllClients(this, std::move(params));
+	getNetStats().teleport.add(TeleportParams::PAYLOAD_BYTES);
+}
+
+void Player::replicateRelease()
+{
+	if (!gEnv->bMultiplayer || !gEnv->bServer)
+		return;
+
+	// Clients apply the offset to the position in the update the RMI is attached to.
+	syncNetState(true);
+
+	const float range = 32767 * NetQuantize::OFFSET_STEP;
+
+	ReleaseParams params;
+	params.objectId = m_grabbedObject->GetId();
+
+	Vec3 offset = m_grabbedObject->GetWorldPos() - netPosition();
+	params.absolute = fabsf(offset.x) > range || fabsf(offset.y) > range || fabsf(offset.z) > range;
+	params.pos = m_grabbedObject->GetWorldPos();
+	for (int i = 0; i < 3; i++)
+		params.offset[i] = NetQuantize::offset(offset[i]);
+
+	params.rotation = NetQuantize::rotation(m_grabbedObject->GetRotation());
+	params.scale = NetQuantize::scale(m_grabbedObject->GetScale().x);
+
+	SRmi<RMI_WRAP(&Player::ClRelease)>::InvokeOnAllClients(this, std::move(params));
+	getNetStats().release.add(ReleaseParams::PAYLOAD_BYTES);
+}
+
+bool Player::ClTeleport(TeleportParams&& params, INetChannel* pNetChannel)
+{
+	// Also delivered to the local client of a listen server, which already teleported.
+	if (gEnv->bServer)
+		return true;
+
+	getNetStats().teleport.add(TeleportParams::PAYLOAD_BYTES);
+
+	IEntity* entity = gEnv->pEntitySystem->GetEntity(params.portalId);
+	Teleport* portal = entity ? entity->GetComponent<Teleport>() : nullptr;
+
+	if (!portal || !portal->getGateway())
+		return true;
+
+	// Position and scale already came with the state update, only the transit itself is left.
+	const PortalTransform& link = portal->getPortalTransform();
+	applyTransit(link.angle, link.scale);
+
+	return true;
+}
+
+bool Player::ClRelease(ReleaseParams&& params, INetChannel* pNetChannel)
+{
+	if (gEnv->bServer)
+		return true;
+
+	getNetStats().release.add(ReleaseParams::PAYLOAD_BYTES);
+
+	IEntity* object = gEnv->pEntitySystem->GetEntity(params.objectId);
+	if (!object)
+		return true;
+
+	if (object == m_grabbedObject) {
+		holdGrabbedPhysics(false);
+		m_grabbedObject = nullptr;
+	}
+
+	Vec3 pos = params.pos;
+	if (!params.absolute) {
+		Vec3 offset(NetQuantize::unoffset(params.offset[0]), NetQuantize::unoffset(params.offset[1]), NetQuantize::unoffset(params.offset[2]));
+		pos = netPosition() + offset;
+	}
+
+	object->SetPosRotScale(pos, NetQuantize::unrotation(params.rotation), Vec3(NetQuantize::unscale(params.scale)));
+
+	return true;
+}
+
 void Player::HandleInputFlagChange(const CEnumFlags<EInputFlag> flags, const CEnumFlags<EActionActivationMode> activationMode, const EInputFlagType type)
 {
+	wake();
+
 	switch (type)
 	{
 	case EInputFlagType::Hold:
@@ -5,6 +5,12 @@
 #include <DefaultComponents/Physics/RigidBodyComponent.h>
 #include <DefaultComponents/Physics/CharacterControllerComponent.h>
 #include <DefaultComponents/Cameras/CameraComponent.h>
+#include <CryNetwork/Rmi.h>
+
+#include <unordered_map>
+
+#include "Components/Teleport.h"
+#include "NetReplication.h"
 
 class Player final : public IEntityComponent
 {
@@ -15,6 +21,23 @@ class Player final : public IEntityComponent
 	const float CHARACHTER_RADIUS = 0.8;
 	const float CHARACHTER_HEIGHT = 1.8;
 	const float CHARACHTER_MOVESPEED = 50.f;
+	const float SCALE_BLEND_TIME = 0.15f;
+
+	static const int MAX_PORTAL_HOPS = 4;
+
+	static constexpr EEntityAspects STATE_ASPECT = eEA_GameServerA;
+	static constexpr EEntityAspects BASE_ASPECT = eEA_GameServerB;
+
+	const float NET_BLEND_RATE = 15.f; // per second, remote copies ease toward the received position
+	const float NET_SNAP_DIST = 4.f;   // at scale 1, further jumps are not blended
+
+	struct PortalRayHit
+	{
+		ray_hit hit;               // hit in the space where the ray stopped
+		float dist = 0.f;          // distance along the unfolded ray, in camera space units
+		int hops = 0;
+		PortalTransform transform; // camera space -> space of the hit
+	};
 
 	Cry::DefaultComponents::CInputComponent* m_input = nullptr;
 	Cry::DefaultComponents::CCharacterControllerComponent* m_character = nullptr;
@@ -22,6 +45,10 @@ class Player final : public IEntityComponent
 
 	float m_start_scale = 1.f;
 	float m_scale = 1.f;
+	float m_scaleFrom = 1.f;
+	float m_scaleTarget = 1.f;
+	float m_scaleBlend = 1.f; // 1 when no resize is in progress
+	float m_nearPlaneBase = 0.f; // camera Near Plane property, scaled by ViewScalePolicy
 	bool m_debug = false;
 	bool m_shouldTeleport = false;
 	Vec3 m_teleportVelocity = ZERO;
@@ -29,8 +56,44 @@ class Player final : public IEntityComponent
 	Matrix34 m_bodyOrientation = IDENTITY;
 	Vec3 m_cameraViewDir = FORWARD_DIRECTION;
 	Vec2 m_mouseDelta = ZERO;
+	Ang3 m_viewAngles = Ang3(ZERO);
 
 	std::vector<Vec3> m_grabbedObjectPoints;
+
+	// Curved part of the held object, in entity local space.
+	struct GrabbedPrimitive
+	{
+		int type = GEOM_SPHERE; // GEOM_SPHERE, GEOM_CAPSULE or GEOM_CYLINDER
+		Matrix34 tm = IDENTITY; // part space -> entity local space
+		Vec3 center = ZERO;
+		Vec3 axis = Vec3(0, 0, 1);
+		float r = 0.f;
+		float hh = 0.f;
+	};
+
+	std::vector<GrabbedPrimitive> m_grabbedPrimitives;
+
+	// Sample set of a grabbable entity, built on first pick or ahead of a portal transit.
+	struct GrabSamples
+	{
+		IPhysicalEntity* physics = nullptr; // the entity was re-physicalized if this changed
+		std::vector<Vec3> points;
+		std::vector<GrabbedPrimitive> primitives;
+	};
+
+	std::unordered_map<EntityId, GrabSamples> m_grabSampleCache;
+
+	// Physics state of the held body, restored on release.
+	struct HeldBody
+	{
+		std::vector<unsigned int> partFlags;
+		Vec3 gravity = ZERO;
+		Vec3 gravityFreefall = ZERO;
+	};
+
+	HeldBody m_heldBody;
+	bool m_sweepGrabbedObject = false;
+	bool m_snapGrabbedObject = false;
 	
 	enum class EInputFlag : uint8
 	{
@@ -50,18 +113,107 @@ class Player final : public IEntityComponent
 
 	IEntity* m_grabbedObject = nullptr;
 
+	// Position the replicated offsets are relative to, only resent once the player leaves the offset range.
+	struct NetBase
+	{
+		uint8 seq = 0;
+		Vec3 pos = ZERO;
+
+		static const uint32 PAYLOAD_BYTES = 1 + 12;
+
+		void SerializeWith(TSerialize ser)
+		{
+			ser.Value("seq", seq);
+			ser.Value("pos", pos, 'wrld');
+		}
+	};
+
+	// Server state as last sent, kept quantized so unchanged frames are not resent.
+	struct NetState
+	{
+		uint8 baseSeq = 0;                     // NetBase the offset applies to
+		int16 offset[3] = { 0, 0, 0 };         // position relative to the base
+		int16 yaw = 0;
+		int16 pitch = 0;
+		uint16 scale = 0;
+		EntityId grabbedId = INVALID_ENTITYID;
+		uint16 grabbedScale = 0;
+		NetQuantize::Rotation grabbedRotation; // relative to the body yaw
+
+		// Uncompressed size for pl_netReport, the compression policies usually send less.
+		static const uint32 PAYLOAD_BYTES = 1 + 6 + 2 + 2 + 2 + 4 + 2 + 7;
+
+		void SerializeWith(TSerialize ser);
+		bool operator==(const NetState& other) const;
+	};
+
+	// Teleports are sent as the portal taken, clients replay its cached transform.
+	struct TeleportParams
+	{
+		EntityId portalId = INVALID_ENTITYID;
+
+		static const uint32 PAYLOAD_BYTES = 4;
+
+		void SerializeWith(TSerialize ser) { ser.Value("portal", portalId, 'eid'); }
+	};
+
+	// Result of a forced perspective solve, the offset is relative to the player.
+	struct ReleaseParams
+	{
+		EntityId objectId = INVALID_ENTITYID;
+		bool absolute = false; // offset out of range, pos is sent instead
+		int16 offset[3] = { 0, 0, 0 };
+		Vec3 pos = ZERO;
+		NetQuantize::Rotation rotation;
+		uint16 scale = 0;
+
+		static const uint32 PAYLOAD_BYTES = 4 + 1 + 6 + 7 + 2;
+
+		void SerializeWith(TSerialize ser);
+	};
+
+	NetState m_netState;
+	NetBase m_netBase;
+	Vec3 m_netTargetPos = ZERO;
+	bool m_netHasTarget = false;
+
 
 	void updateMovement(float delta);
 	void updateCamera(float delta);
 	void lockLocalPoints();
+	const GrabSamples& getGrabSamples(IEntity* entity);
+	static void buildGrabSamples(IEntity* entity, GrabSamples& samples);
+	static Vec3 supportPoint(const GrabbedPrimitive& prim, const Matrix34& worldTM, const Vec3& dir);
 	void updateGrabbedObject(float delta);
+	void holdGrabbedPhysics(bool hold);
 	void doPerspectiveScaling();
 	void pickObject();
-	IEntity* rayCastFromCamera(ray_hit &hit, const Vec3 &dir, int objTypes);
+	IEntity* rayCastFromCamera(PortalRayHit &result, const Vec3 &dir, int objTypes);
+	IEntity* rayCastThroughPortals(PortalRayHit &result, const Vec3 &origin, const Vec3 &dir, int objTypes);
 	void applyCharacterScale(float scale);
+	void updateScale(float delta);
+	void updateNearPlane();
+	bool resizeCharacter(float scale);
+
+	bool isNetAuthority() const;
+	NetState captureNetState() const;
+	void applyNetState(const NetState& state);
+	void applyNetPosition();
+	void blendNetPosition(float delta);
+	Vec3 netPosition() const;
+	void syncNetState(bool force);
+	void applyTransit(float zAng, float scale);
+	void replicateRelease();
+	bool ClTeleport(TeleportParams&& params, INetChannel* pNetChannel);
+	bool ClRelease(ReleaseParams&& params, INetChannel* pNetChannel);
+
+	void wake();
 
 public:
+	bool tick(float delta);
 	void teleport(Vec3 to, float zAng, float setScale);
+	void replicateTeleport(EntityId portalId);
+	void prefetchGrabSamples(IEntity* entity);
 	float getScale();
 
 public:
@@ -77,12 +229,16 @@ public:
 		desc.SetComponentFlags({ IEntityComponent::EFlags::Transform, IEntityComponent::EFlags::Socket, IEntityComponent::EFlags::Attach });
 
 		desc.AddMember(&Player::m_start_scale, 'scal', "Scale", "Scale", "Start Scaling", 1.f);
+		desc.AddMember(&Player::m_sweepGrabbedObject, 'swep', "SweepGrabbed", "Sweep Grabbed Object", "Held objects are stopped by walls", false);
 	}
 
 protected:
 	virtual Cry::Entity::EventFlags GetEventMask() const override;
 	virtual void Initialize() override;
+	virtual void OnShutDown() override;
 	virtual void ProcessEvent(const SEntityEvent& event) override;
+	virtual bool NetSerialize(TSerialize ser, EEntityAspects aspect, uint8 profile, int flags) override;
+	virtual NetworkAspectType GetNetSerializeAspectMask() const override { return STATE_ASPECT | BASE_ASPECT; }
 	void HandleInputFlagChange(const CEnumFlags<EInputFlag> flags, const CEnumFlags<EActionActivationMode> activationMode, const EInputFlagType type = EInputFlagType::Hold);
 };
 
@@ -16,18 +16,45 @@
 #include <CryGame/IGameFramework.h>
 
 #include "Components/Player.h"
+#include "TickScheduler.h"
+#include "GameLog.h"
 
 bool debug = false;
 
 void Teleport::Initialize()
 {
 	m_collider = m_pEntity->GetOrCreateComponent<Cry::DefaultComponents::CBoxPrimitiveComponent>();
-	
+	m_trigger = m_pEntity->GetOrCreateComponent<IEntityTriggerComponent>();
+}
+
+void Teleport::OnShutDown()
+{
+	getTickScheduler().remove(this);
 }
 
 Cry::Entity::EventFlags Teleport::GetEventMask() const
 {
-	return Cry::Entity::EEvent::Update | Cry::Entity::EEvent::GameplayStarted;
+	return Cry::Entity::EEvent::GameplayStarted | Cry::Entity::EEvent::TransformChanged | Cry::Entity::EEvent::EnterArea | Cry::Entity::EEvent::LeaveArea;
+}
+
+const PortalTransform& Teleport::getPortalTransform()
+{
+	if (m_portalTransformDirty && m_gateway) {
+		Teleport* teleportComp = m_gateway->GetComponent<Teleport>();
+		assert(teleportComp && "Teleport component found!");
+
+		float alpha1 = m_pEntity->GetWorldRotation().GetRotZ();
+		float alpha2 = m_gateway->GetWorldRotation().GetRotZ();
+
+		PortalTransform& link = m_portalTransform;
+		link.angle = alpha2 - alpha1;
+		link.scale = teleportComp->scale / scale;
+		link.tm = Matrix34::Create(Vec3(link.scale), Quat::CreateRotationZ(link.angle), m_gateway->GetWorldPos())
+			* Matrix34::CreateTranslationMat(-m_pEntity->GetWorldPos());
+
+		m_portalTransformDirty = false;
+	}
+	return m_portalTransform;
 }
 
 bool isPointInside(const Vec3& point, const Vec3 &selfPos, const Vec3 &size, float zAng) {
@@ -50,12 +77,162 @@ bool isPointInside(const Vec3& point, const Vec3 &selfPos, const Vec3 &size, flo
 	return aabb.IsContainPoint(newPoint);
 }
 
+void Teleport::detectTransit()
+{
+	if (m_player == nullptr || m_gateway == nullptr)
+		return;
+
+	float alpha1 = m_pEntity->GetWorldRotation().GetRotZ();
+	Vec3 playerPos = m_player->GetWorldPos();
+	Vec3 pos = m_pEntity->GetWorldPos();
+
+	//bool playerInsideNow = aabb.IsContainPoint(playerPos + Vec3(0, 0, playerComp->getScale()));
+
+	m_playerInsideNow = isPointInside(playerPos, pos, m_collider->m_size, alpha1);
+
+	if (!m_prefetched && !m_prefetchPending)
+		m_prefetchPending = predictTransit(playerPos, pos, m_collider->m_size, alpha1);
+}
+
+bool Teleport::predictTransit(const Vec3& playerPos, const Vec3& selfPos, const Vec3& size, float zAng) const
+{
+	IPhysicalEntity* physEnt = m_player->GetPhysics();
+	pe_status_dynamics dynamics;
+
+	if (!physEnt || !physEnt->GetStatus(&dynamics))
+		return false;
+
+	Vec3 local = (playerPos - selfPos).GetRotated(Vec3(0, 0, 1), -zAng);
+	Vec3 velocity = dynamics.v.GetRotated(Vec3(0, 0, 1), -zAng);
+
+	Vec3 closest(CLAMP(local.x, -size.x, size.x), CLAMP(local.y, -size.y, size.y), CLAMP(local.z, -size.z, size.z));
+	Vec3 toBox = closest - local;
+	float dist = toBox.len();
+
+	if (dist < 0.001f)
+		return true;
+
+	float closingSpeed = velocity.dot(toBox / dist);
+
+	return closingSpeed > 0 && dist < closingSpeed * PREFETCH_HORIZON;
+}
+
+void Teleport::prefetchGateway(Player* playerComp)
+{
+	const PortalTransform& link = getPortalTransform();
+
+	Vec3 center = m_gateway->GetWorldPos();
+	float radius = PREFETCH_RADIUS * playerComp->getScale() * link.scale;
+
+	gEnv->p3DEngine->AddPrecachePoint(center, m_gateway->GetForwardDir(), PREFETCH_HORIZON * 2, 1.f);
+
+	IPhysicalEntity** entities = nullptr;
+	int count = gEnv->pPhysicalWorld->GetEntitiesInBox(center - Vec3(radius), center + Vec3(radius), entities, ent_rigid | ent_sleeping_rigid);
+
+	pe_action_awake awake;
+
+	for (int i = 0; i < count; i++) {
+		entities[i]->Action(&awake);
+
+		IEntity* entity = gEnv->pEntitySystem->GetEntityFromPhysics(entities[i]);
+		if (entity)
+			playerComp->prefetchGrabSamples(entity);
+	}
+
+	if (debug) {
+		IPersistantDebug* db = gEnv->pGameFramework->GetIPersistantDebug();
+		db->Begin("prefetch", false);
+		db->AddSphere(center, radius, ColorF(0, 1, 0, 0.2f), 2.f);
+	}
+}
+
+void Teleport::updateWakeArea(float playerScale)
+{
+	m_wakeScale = playerScale;
+
+	// Wide enough to wake PREFETCH_HORIZON before a player at top speed reaches the portal.
+	const Vec3 margin(std::max(WAKE_MARGIN, PREFETCH_MAX_SPEED * playerScale * PREFETCH_HORIZON));
+	m_trigger->SetTriggerBounds(AABB(-m_collider->m_size - margin, m_collider->m_size + margin));
+
+	float alpha1 = m_pEntity->GetWorldRotation().GetRotZ();
+	m_playerNearby = m_player && isPointInside(m_player->GetWorldPos(), m_pEntity->GetWorldPos(), m_collider->m_size + margin, alpha1);
+	if (m_playerNearby)
+		getTickScheduler().teleports.wake(this);
+}
+
+void Teleport::updateWakeAreas(float playerScale)
+{
+	IEntityItPtr it = gEnv->pEntitySystem->GetEntityIterator();
+	it->MoveFirst();
+
+	while (!it->IsEnd()) {
+		IEntity* entity = it->Next();
+		Teleport* teleportComp = entity ? entity->GetComponent<Teleport>() : nullptr;
+
+		if (teleportComp && teleportComp->m_wakeScale > 0.f && fabsf(log2f(playerScale / teleportComp->m_wakeScale)) > 0.25f)
+			teleportComp->updateWakeArea(playerScale);
+	}
+}
+
+bool Teleport::tick(float delta)
+{
+	//if (gEnv->IsEditor())
+	//	return;
+
+	if (m_player == nullptr || m_gateway == nullptr)
+		return false;
+
+	Player* playerComp = m_player->GetComponent<Player>();
+	assert(playerComp && "No player component found!");
+
+	// Warm up the destination before the player gets there.
+	if (m_prefetchPending) {
+		m_prefetchPending = false;
+		m_prefetched = true;
+		prefetchGateway(playerComp);
+	}
+
+	// Clients get teleports from the server, they only warm their side.
+	if (gEnv->bMultiplayer && !gEnv->bServer)
+		return m_playerNearby && !m_prefetched;
+
+	Vec3 pos = m_pEntity->GetWorldPos();
+	Vec3 size = m_collider->m_size;
+	Vec3 offs = Vec3(0, 0, size.z);
+
+	if (debug) {
+		IPersistantDebug* db = gEnv->pGameFramework->GetIPersistantDebug();
+		db->Begin(m_pEntity->GetGuid().ToString(), true);
+		db->AddDirection(pos + offs, 1, m_pEntity->GetForwardDir(), ColorF(1, 1, 1), 1);
+	}
+
+	Vec3 playerPos = m_player->GetWorldPos();
+
+	if (m_playerInsideNow) {
+		m_playerInside = true;
+	}
+
+	else if (m_playerInside) {
+		m_playerInside = false;
+
+		const PortalTransform& link = getPortalTransform();
+
+		playerComp->teleport(link.tm * playerPos, link.angle, link.scale);
+		playerComp->replicateTeleport(m_pEntity->GetId());
+		m_prefetched = false;
+
+		GAME_LOG(Teleport, Info, 0.f, "TP! %s -> %s", m_pEntity->GetName(), m_gateway->GetName());
+	}
+
+	return m_playerNearby || m_playerInside;
+}
+
 void Teleport::ProcessEvent(const SEntityEvent& event)
 {
 	switch (event.event) {
 		case Cry::Entity::EEvent::GameplayStarted:
 		{
-			CryLogAlways("Gameplay started!");
+			GAME_LOG(Teleport, Debug, 0.f, "Gameplay started: %s", m_pEntity->GetName());
 			m_player = gEnv->pEntitySystem->FindEntityByName("Player");
 
 			IEntityLink* link = m_pEntity->GetEntityLinks();
@@ -68,67 +245,50 @@ void Teleport::ProcessEvent(const SEntityEvent& event)
 				link = link->next;
 			}
 
+			m_portalTransformDirty = true;
+			if (m_gateway) {
+				Teleport* teleportComp = m_gateway->GetComponent<Teleport>();
+				if (teleportComp)
+					stl::push_back_unique(teleportComp->m_incoming, m_pEntity->GetId());
+			}
+
+			// Only a player inside the trigger keeps the teleport ticking.
+			Player* playerComp = m_player ? m_player->GetComponent<Player>() : nullptr;
+			updateWakeArea(playerComp ? playerComp->getScale() : 1.f);
+			getTickScheduler().teleports.wake(this);
+
 			if (!m_player)
-				CryLogAlways("Player entity not found");
+				GAME_LOG(Teleport, Warning, 1.f, "%s: player entity not found", m_pEntity->GetName());
 
 			if (!m_gateway)
-				CryLogAlways("Gateway entity not found");
+				GAME_LOG(Teleport, Warning, 1.f, "%s: gateway entity not found", m_pEntity->GetName());
 		}
 		break;
 
-		case Cry::Entity::EEvent::Update:
+		case Cry::Entity::EEvent::EnterArea:
+		case Cry::Entity::EEvent::LeaveArea:
 		{
-			//if (gEnv->IsEditor())
-			//	return;
-
-			if (m_player == nullptr || m_gateway == nullptr)
+			if (m_player == nullptr || (EntityId)event.nParam[0] != m_player->GetId())
 				return;
 
-			const float delta = event.fParam[0];
-
-			Vec3 pos = m_pEntity->GetWorldPos();
-			Vec3 size = m_collider->m_size;
-			Vec3 offs = Vec3(0, 0, size.z);
-
-			if (debug) {
-				IPersistantDebug* db = gEnv->pGameFramework->GetIPersistantDebug();
-				db->Begin(m_pEntity->GetGuid().ToString(), true);
-				db->AddDirection(pos + offs, 1, m_pEntity->GetForwardDir(), ColorF(1, 1, 1), 1);
-			}
-
-			Player* playerComp = m_player->GetComponent<Player>();
-			assert(playerComp && "No player component found!");
-
-			Vec3 playerPos = m_player->GetWorldPos();
-			
-			float alpha1 = m_pEntity->GetWorldRotation().GetRotZ();
-			float alpha2 = m_gateway->GetWorldRotation().GetRotZ();
-
-			//bool playerInsideNow = aabb.IsContainPoint(playerPos + Vec3(0, 0, playerComp->getScale()));
-
-			bool playerInsideNow = isPointInside(playerPos, pos, size, alpha1);
-
-			if (playerInsideNow) {
-				m_playerInside = true;
-			}
-
-			else if (m_playerInside) {
-				m_playerInside = false;
-
-				Teleport* teleportComp = m_gateway->GetComponent<Teleport>();
-				assert(teleportComp && "Teleport component found!");
-	
-				float totalScale = teleportComp->scale / scale;
-
-				float angDiff = alpha2 - alpha1;
-				Vec3 diff = (playerPos - pos) * totalScale;
-				diff = diff.GetRotated(Vec3(0, 0, 1), angDiff);
-
-				Vec3 newPlayerPos = m_gateway->GetWorldPos() + diff;
-
-				playerComp->teleport(newPlayerPos, angDiff, totalScale);
+			m_playerNearby = event.event == Cry::Entity::EEvent::EnterArea;
+			if (m_playerNearby)
+				getTickScheduler().teleports.wake(this);
+			else
+				m_prefetched = m_prefetchPending = false;
+		}
+		break;
 
-				CryLogAlways("TP!");
+		case Cry::Entity::EEvent::TransformChanged:
+		{
+			// Both ends of a link feed the cached transform.
+			m_portalTransformDirty = true;
+
+			for (EntityId id : m_incoming) {
+				IEntity* entity = gEnv->pEntitySystem->GetEntity(id);
+				Teleport* teleportComp = entity ? entity->GetComponent<Teleport>() : nullptr;
+				if (teleportComp)
+					teleportComp->m_portalTransformDirty = true;
 			}
 		}
 		break;
@@ -3,18 +3,66 @@
 #include <CryEntitySystem/IEntitySystem.h>
 #include <DefaultComponents/Physics/BoxPrimitiveComponent.h>
 
+class Player;
+
+// Maps the space around a portal into the space around its gateway.
+struct PortalTransform
+{
+	Matrix34 tm = IDENTITY; // point transform, includes rotation and scale
+	float angle = 0.f;      // rotation around Z applied on transit
+	float scale = 1.f;      // gateway size relative to the portal
+
+	Vec3 transformDir(const Vec3& dir) const { return dir.GetRotated(Vec3(0, 0, 1), angle); }
+
+	void append(const PortalTransform& next)
+	{
+		tm = next.tm * tm;
+		angle += next.angle;
+		scale *= next.scale;
+	}
+};
+
 class Teleport final : public IEntityComponent
 {
 	bool m_playerInside = false;
+	bool m_playerInsideNow = false;
+	bool m_playerNearby = false; // inside the wake trigger, the teleport sleeps otherwise
+	bool m_prefetchPending = false;
+	bool m_prefetched = false;
 	IEntity* m_gateway = nullptr;
 	IEntity* m_player = nullptr;
 	Cry::DefaultComponents::CBoxPrimitiveComponent *m_collider = nullptr;
+	IEntityTriggerComponent* m_trigger = nullptr;
 
 	const string TP_LINK_NAME = "TP";
+	const float WAKE_MARGIN = 2.f;
+	const float PREFETCH_HORIZON = 1.5f; // seconds ahead a transit is predicted
+	const float PREFETCH_RADIUS = 8.f;   // warmed area around the gateway, meters at player scale 1
+	const float PREFETCH_MAX_SPEED = 10.f; // expected top player speed at scale 1, sizes the wake trigger
+	float m_wakeScale = 0.f;             // player scale the wake trigger was sized for
 	float scale = 1.f;
 
+	PortalTransform m_portalTransform;
+	bool m_portalTransformDirty = true;
+	std::vector<EntityId> m_incoming; // portals linked to this one as their gateway
+
 	//Vec3 m_size;
 
+public:
+	IEntity* getGateway() const { return m_gateway; }
+	const PortalTransform& getPortalTransform();
+
+	void detectTransit();
+	bool tick(float delta);
+
+	// Resizes every wake trigger that was sized for a noticeably different player scale.
+	static void updateWakeAreas(float playerScale);
+
+private:
+	bool predictTransit(const Vec3& playerPos, const Vec3& selfPos, const Vec3& size, float zAng) const;
+	void prefetchGateway(Player* playerComp);
+	void updateWakeArea(float playerScale);
+
 public:
 	Teleport() = default;
 	virtual ~Teleport() = default;
@@ -32,6 +80,7 @@ public:
 
 protected:
 	virtual void Initialize() override;
+	virtual void OnShutDown() override;
 
 	virtual Cry::Entity::EventFlags GetEventMask() const override;
 	virtual void ProcessEvent(const SEntityEvent& event) override;
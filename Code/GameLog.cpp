@@ -0,0 +1,173 @@
+#include "StdAfx.h"
+#include "GameLog.h"
+
+static const char* const s_categoryNames[] = { "Plugin", "Player", "Teleport", "Net" };
+static_assert(CRY_ARRAY_COUNT(s_categoryNames) == (size_t)ELogCategory::Count, "name every log category");
+
+bool LogSite::allow(float interval, uint32& suppressedOut)
+{
+	if (interval <= 0.f) {
+		suppressedOut = 0;
+		return true;
+	}
+
+	const int64 now = gEnv->pTimer->GetAsyncTime().GetMilliSecondsAsInt64();
+	int64 last = lastMs.load(std::memory_order_relaxed);
+
+	if (now - last < (int64)(interval * 1000.f) || !lastMs.compare_exchange_strong(last, now, std::memory_order_relaxed)) {
+		suppressed.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	suppressedOut = suppressed.exchange(0, std::memory_order_relaxed);
+	return true;
+}
+
+GameLog::GameLog()
+{
+	for (size_t i = 0; i < QUEUE_SIZE; i++)
+		m_slots[i].seq.store(i, std::memory_order_relaxed);
+
+	for (int& level : m_levels)
+		level = (int)ELogSeverity::Info;
+}
+
+void GameLog::registerCVars()
+{
+	REGISTER_CVAR2("pl_log_plugin", &m_levels[(int)ELogCategory::Plugin], (int)ELogSeverity::Info, VF_NULL, "Plugin log level: 0 off, 1 errors, 2 warnings, 3 info, 4 debug");
+	REGISTER_CVAR2("pl_log_player", &m_levels[(int)ELogCategory::Player], (int)ELogSeverity::Info, VF_NULL, "Player log level: 0 off, 1 errors, 2 warnings, 3 info, 4 debug");
+	REGISTER_CVAR2("pl_log_teleport", &m_levels[(int)ELogCategory::Teleport], (int)ELogSeverity::Info, VF_NULL, "Teleport log level: 0 off, 1 errors, 2 warnings, 3 info, 4 debug");
+	REGISTER_CVAR2("pl_log_net", &m_levels[(int)ELogCategory::Net], (int)ELogSeverity::Info, VF_NULL, "Replication log level: 0 off, 1 errors, 2 warnings, 3 info, 4 debug");
+}
+
+void GameLog::unregisterCVars()
+{
+	if (gEnv->pConsole) {
+		gEnv->pConsole->UnregisterVariable("pl_log_plugin");
+		gEnv->pConsole->UnregisterVariable("pl_log_player");
+		gEnv->pConsole->UnregisterVariable("pl_log_teleport");
+		gEnv->pConsole->UnregisterVariable("pl_log_net");
+	}
+}
+
+void GameLog::start()
+{
+	if (m_running.exchange(true))
+		return;
+
+	if (!gEnv->pThreadManager->SpawnThread(this, "GameLog")) {
+		m_running = false;
+		CryWarning(VALIDATOR_MODULE_GAME, VALIDATOR_WARNING, "GameLog thread could not be spawned, messages are written inline");
+	}
+}
+
+void GameLog::stop()
+{
+	if (!m_running.exchange(false))
+		return;
+
+	m_wake.Set();
+	gEnv->pThreadManager->JoinThread(this, eJM_Join);
+
+	// Pushes racing with the shutdown may still have landed in the queue.
+	flush();
+}
+
+bool GameLog::enqueue(const Entry& entry)
+{
+	size_t pos = m_head.load(std::memory_order_relaxed);
+	Slot* slot;
+
+	for (;;) {
+		slot = &m_slots[pos & (QUEUE_SIZE - 1)];
+		const size_t seq = slot->seq.load(std::memory_order_acquire);
+		const intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+
+		if (diff == 0) {
+			if (m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				break;
+		}
+		else if (diff < 0) {
+			return false; // full
+		}
+		else {
+			pos = m_head.load(std::memory_order_relaxed);
+		}
+	}
+
+	slot->entry = entry;
+	slot->seq.store(pos + 1, std::memory_order_release);
+	return true;
+}
+
+bool GameLog::pending() const
+{
+	return m_slots[m_tail & (QUEUE_SIZE - 1)].seq.load(std::memory_order_acquire) == m_tail + 1;
+}
+
+bool GameLog::dequeue(Entry& entry)
+{
+	Slot& slot = m_slots[m_tail & (QUEUE_SIZE - 1)];
+	if (slot.seq.load(std::memory_order_acquire) != m_tail + 1)
+		return false;
+
+	entry = slot.entry;
+	slot.seq.store(m_tail + QUEUE_SIZE, std::memory_order_release);
+	m_tail++;
+	return true;
+}
+
+void GameLog::write(const Entry& entry)
+{
+	char message[512];
+	entry.format(entry, message, sizeof(message));
+
+	stack_string text;
+	text.Format("[%s] %s", s_categoryNames[(int)entry.category], message);
+	if (entry.suppressed)
+		text.AppendFormat(" (%u similar suppressed)", entry.suppressed);
+
+	switch (entry.severity) {
+	case ELogSeverity::Error:
+		gEnv->pLog->LogError("%s", text.c_str());
+		break;
+	case ELogSeverity::Warning:
+		gEnv->pLog->LogWarning("%s", text.c_str());
+		break;
+	case ELogSeverity::Info:
+		gEnv->pLog->LogAlways("%s", text.c_str());
+		break;
+	case ELogSeverity::Debug:
+		gEnv->pLog->Log("%s", text.c_str());
+		break;
+	}
+}
+
+void GameLog::flush()
+{
+	Entry entry;
+	while (dequeue(entry))
+		write(entry);
+
+	if (const uint32 dropped = m_dropped.exchange(0, std::memory_order_relaxed))
+		gEnv->pLog->LogWarning("[Log] queue full, %u messages dropped", dropped);
+}
+
+void GameLog::ThreadEntry()
+{
+	while (m_running.load(std::memory_order_relaxed)) {
+		flush();
+
+		// push() only signals while this thread is waiting. The queue is checked again after
+		// announcing the wait, so a message pushed in between is never missed.
+		// The timeout only reports drops that happened without a wake.
+		m_waiting.store(true, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+
+		if (!pending())
+			m_wake.Wait(IDLE_WAIT_MS);
+
+		m_waiting.store(false, std::memory_order_relaxed);
+		m_wake.Reset();
+	}
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <CryThreading/IThreadManager.h>
+#include <CryThreading/CryThread.h>
+
+#include <atomic>
+#include <tuple>
+#include <type_traits>
+
+enum class ELogCategory : uint8
+{
+	Plugin,
+	Player,
+	Teleport,
+	Net,
+	Count
+};
+
+enum class ELogSeverity : uint8
+{
+	Error = 1,
+	Warning,
+	Info,
+	Debug
+};
+
+// Call site state of GAME_LOG, messages closer than the interval are counted and dropped.
+struct LogSite
+{
+	std::atomic<int64> lastMs{ INT64_MIN / 2 };
+	std::atomic<uint32> suppressed{ 0 };
+
+	bool allow(float interval, uint32& suppressedOut);
+};
+
+// Messages are formatted on a background thread, so string arguments are copied.
+struct LogString
+{
+	char text[48];
+};
+
+namespace LogDetail
+{
+	template<class T>
+	auto capture(const T& value)
+	{
+		if constexpr (std::is_convertible<T, const char*>::value) {
+			LogString s;
+			cry_strcpy(s.text, value ? (const char*)value : "(null)");
+			return s;
+		}
+		else {
+			static_assert(std::is_trivially_copyable<T>::value, "log arguments are copied to another thread, pass c_str() for strings");
+			return value;
+		}
+	}
+
+	inline const char* unwrap(const LogString& s) { return s.text; }
+
+	template<class T>
+	const T& unwrap(const T& value) { return value; }
+}
+
+class GameLog : public IThread
+{
+public:
+	static const size_t ARG_BYTES = 96;
+
+	struct Entry
+	{
+		void (*format)(const Entry& entry, char* out, size_t size);
+		const char* fmt; // string literal
+		ELogCategory category;
+		ELogSeverity severity;
+		uint32 suppressed;
+		alignas(8) uint8 args[ARG_BYTES];
+	};
+
+private:
+	static const size_t QUEUE_SIZE = 1024; // power of two
+	static const uint32 IDLE_WAIT_MS = 250;
+
+	// Bounded multi-producer queue, the flush thread is the only consumer.
+	struct Slot
+	{
+		std::atomic<size_t> seq;
+		Entry entry;
+	};
+
+	Slot m_slots[QUEUE_SIZE];
+	std::atomic<size_t> m_head{ 0 };
+	size_t m_tail = 0;
+	std::atomic<uint32> m_dropped{ 0 };
+
+	CryEvent m_wake;
+	std::atomic<bool> m_waiting{ false }; // flush thread is about to sleep or sleeping
+	std::atomic<bool> m_running{ false };
+
+	int m_levels[(int)ELogCategory::Count];
+
+	template<class Tuple>
+	static void formatEntry(const Entry& entry, char* out, size_t size)
+	{
+		const Tuple& args = *reinterpret_cast<const Tuple*>(entry.args);
+		std::apply([&](const auto&... a) { cry_sprintf(out, size, entry.fmt, LogDetail::unwrap(a)...); }, args);
+	}
+
+	bool enqueue(const Entry& entry);
+	bool dequeue(Entry& entry);
+	bool pending() const;
+	void write(const Entry& entry);
+	void flush();
+
+	// IThread
+	virtual void ThreadEntry() override;
+
+	void wakeIfWaiting()
+	{
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (m_waiting.load(std::memory_order_relaxed))
+			m_wake.Set();
+	}
+
+public:
+	GameLog();
+
+	void registerCVars();
+	void unregisterCVars();
+
+	// The flush thread, messages are written inline while it is not running.
+	void start();
+	void stop();
+
+	bool enabled(ELogCategory category, ELogSeverity severity) const
+	{
+		return (int)severity <= m_levels[(int)category];
+	}
+
+	template<class... Args>
+	void push(ELogCategory category, ELogSeverity severity, uint32 suppressed, const char* fmt, const Args&... args)
+	{
+		using Tuple = std::tuple<decltype(LogDetail::capture(args))...>;
+		static_assert(sizeof(Tuple) <= ARG_BYTES, "too many log arguments");
+
+		Entry entry;
+		entry.format = &formatEntry<Tuple>;
+		entry.fmt = fmt;
+		entry.category = category;
+		entry.severity = severity;
+		entry.suppressed = suppressed;
+		new (entry.args) Tuple(LogDetail::capture(args)...);
+
+		if (!m_running.load(std::memory_order_relaxed))
+			write(entry);
+		else if (enqueue(entry))
+			wakeIfWaiting();
+		else
+			m_dropped.fetch_add(1, std::memory_order_relaxed);
+	}
+};
+
+inline GameLog& getGameLog()
+{
+	static GameLog log;
+	return log;
+}
+
+// GAME_LOG(Teleport, Warning, 1.f, "format", args...)
+// Logs at most once per interval seconds from this call site, 0 logs every call.
+// Disabled severities cost one comparison, arguments are not evaluated.
+#define GAME_LOG(category, severity, interval, ...)                                                          \
+	do {                                                                                                     \
+		if (getGameLog().enabled(ELogCategory::category, ELogSeverity::severity)) {                          \
+			static LogSite logSite;                                                                          \
+			uint32 logSuppressed = 0;                                                                        \
+			if (logSite.allow(interval, logSuppressed))                                                      \
+				getGameLog().push(ELogCategory::category, ELogSeverity::severity, logSuppressed, __VA_ARGS__); \
+		}                                                                                                    \
+	} while (0)
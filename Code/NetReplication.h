@@ -0,0 +1,162 @@
+#pragma once
+
+#include <CryGame/IGameFramework.h>
+#include <CryNetwork/INetwork.h>
+
+// Compact encodings and traffic counters for replicated gameplay state.
+namespace NetQuantize
+{
+	// Scales are sent as log2 over [-LOG_SCALE_RANGE, LOG_SCALE_RANGE].
+	constexpr float LOG_SCALE_RANGE = 16.f;
+	// Offsets are sent in int16 steps of this size, which covers +-256 m.
+	constexpr float OFFSET_STEP = 1.f / 128.f;
+
+	inline uint16 scale(float s)
+	{
+		float t = (log2f(std::max(s, 1e-6f)) + LOG_SCALE_RANGE) / (2 * LOG_SCALE_RANGE);
+		return (uint16)(CLAMP(t, 0.f, 1.f) * 65535.f + 0.5f);
+	}
+
+	inline float unscale(uint16 q)
+	{
+		return exp2f(q / 65535.f * (2 * LOG_SCALE_RANGE) - LOG_SCALE_RANGE);
+	}
+
+	inline int16 offset(float v)
+	{
+		return (int16)CLAMP(floorf(v / OFFSET_STEP + 0.5f), -32767.f, 32767.f);
+	}
+
+	inline float unoffset(int16 q)
+	{
+		return q * OFFSET_STEP;
+	}
+
+	inline int16 angle(float a)
+	{
+		return (int16)CLAMP(floorf(a / gf_PI * 32767.f + 0.5f), -32767.f, 32767.f);
+	}
+
+	inline float unangle(int16 q)
+	{
+		return q / 32767.f * gf_PI;
+	}
+
+	// Smallest-three quaternion: the largest component is dropped and rebuilt from the others.
+	struct Rotation
+	{
+		uint8 largest = 3;
+		int16 c[3] = { 0, 0, 0 };
+
+		void SerializeWith(TSerialize ser)
+		{
+			ser.Value("largest", largest);
+			ser.Value("c0", c[0]);
+			ser.Value("c1", c[1]);
+			ser.Value("c2", c[2]);
+
+			if (ser.IsReading())
+				largest &= 3;
+		}
+
+		bool operator==(const Rotation& other) const
+		{
+			return largest == other.largest && c[0] == other.c[0] && c[1] == other.c[1] && c[2] == other.c[2];
+		}
+	};
+
+	inline Rotation rotation(const Quat& q)
+	{
+		float v[4] = { q.v.x, q.v.y, q.v.z, q.w };
+
+		Rotation r;
+		r.largest = 0;
+		for (uint8 i = 1; i < 4; i++) {
+			if (fabsf(v[i]) > fabsf(v[r.largest]))
+				r.largest = i;
+		}
+
+		const float sign = v[r.largest] < 0 ? -1.f : 1.f;
+		for (int i = 0, j = 0; i < 4; i++) {
+			if (i != r.largest)
+				r.c[j++] = (int16)CLAMP(floorf(v[i] * sign * gf_sqrt2 * 32767.f + 0.5f), -32767.f, 32767.f);
+		}
+		return r;
+	}
+
+	inline Quat unrotation(const Rotation& r)
+	{
+		float v[4];
+		float sum = 0;
+		for (int i = 0, j = 0; i < 4; i++) {
+			if (i == r.largest)
+				continue;
+			v[i] = r.c[j++] / (gf_sqrt2 * 32767.f);
+			sum += v[i] * v[i];
+		}
+		v[r.largest] = sqrtf(std::max(1.f - sum, 0.f));
+
+		Quat q(v[3], v[0], v[1], v[2]);
+		q.Normalize();
+		return q;
+	}
+}
+
+struct NetStats
+{
+	struct Counter
+	{
+		uint32 messages = 0;
+		uint32 bytes = 0;
+
+		void add(uint32 size)
+		{
+			messages++;
+			bytes += size;
+		}
+	};
+
+	Counter state;
+	Counter base;
+	Counter release;
+	Counter teleport;
+
+	float since = 0.f;
+	std::vector<int> channels; // connected client channels, tracked on the server
+
+	void reset()
+	{
+		state = base = release = teleport = Counter();
+		since = gEnv->pTimer->GetAsyncCurTime();
+	}
+
+	void report() const
+	{
+		const float elapsed = std::max(gEnv->pTimer->GetAsyncCurTime() - since, 0.001f);
+
+		// Counters are estimates from uncompressed payload sizes, the channel lines are measured by the network.
+		CryLogAlways("Replication estimate over %.1f s (%s, uncompressed):", elapsed, gEnv->bServer ? "produced" : "received");
+		CryLogAlways("  state     %5u msgs %8.1f B/s", state.messages, state.bytes / elapsed);
+		CryLogAlways("  base      %5u msgs %8.1f B/s", base.messages, base.bytes / elapsed);
+		CryLogAlways("  release   %5u msgs %8.1f B/s", release.messages, release.bytes / elapsed);
+		CryLogAlways("  teleport  %5u msgs %8.1f B/s", teleport.messages, teleport.bytes / elapsed);
+
+		if (INetChannel* channel = gEnv->pGameFramework->GetClientChannel()) {
+			INetChannel::SStatistics measured = channel->GetStatistics();
+			CryLogAlways("  server     ping %.1f ms, up %.1f B/s, down %.1f B/s", channel->GetPing(true) * 1000.f, measured.bandwidthUp, measured.bandwidthDown);
+		}
+
+		for (int channelId : channels) {
+			if (INetChannel* channel = gEnv->pGameFramework->GetNetChannel(channelId)) {
+				INetChannel::SStatistics measured = channel->GetStatistics();
+				CryLogAlways("  channel %d ping %.1f ms, up %.1f B/s, down %.1f B/s", channelId, channel->GetPing(true) * 1000.f, measured.bandwidthUp, measured.bandwidthDown);
+			}
+		}
+	}
+};
+
+inline NetStats& getNetStats()
+{
+	static NetStats stats;
+	return stats;
+}
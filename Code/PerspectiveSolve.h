@@ -0,0 +1,108 @@
+#pragma once
+
+// Forced perspective solve and its capture format.
+// Shared with the offline replay tool, so it must not depend on engine headers.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace PerspectiveSolve
+{
+	struct Float3
+	{
+		float x, y, z;
+	};
+
+	inline Float3 sub(const Float3& a, const Float3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+	inline float dot(const Float3& a, const Float3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+	inline float len(const Float3& a) { return sqrtf(dot(a, a)); }
+
+	enum : uint32_t
+	{
+		RAY_HIT = 1 << 0,
+	};
+
+	// One sample point of the held object and what its camera ray ran into.
+	struct Ray
+	{
+		Float3 point;   // world space
+		float hitDist;  // along the unfolded ray from the camera
+		uint32_t flags; // RAY_HIT, portal hop count from bit 8
+	};
+
+	struct Input
+	{
+		Float3 origin;
+		Float3 viewDir;
+		float grabDist;
+		float wallMargin;
+	};
+
+	struct Result
+	{
+		int32_t minRay = -1; // ray limiting the scale, -1 when nothing was hit
+		float minDist = 0.f;
+		float k = 1.f;       // scale and distance factor relative to grabDist
+	};
+
+	inline Result solve(const Input& in, const Ray* rays, size_t count)
+	{
+		Result result;
+		float minQ = 0;
+
+		for (size_t i = 0; i < count; i++) {
+			if (!(rays[i].flags & RAY_HIT))
+				continue;
+
+			float ln = len(sub(rays[i].point, in.origin));
+			float hit_dist = std::max(rays[i].hitDist - in.wallMargin, 0.f);
+
+			float q = (hit_dist - ln) / ln;
+
+			if (result.minRay == -1 || q < minQ) {
+				result.minDist = hit_dist;
+				result.minRay = (int32_t)i;
+				minQ = q;
+			}
+		}
+
+		if (result.minRay == -1)
+			return result;
+
+		Float3 old = sub(rays[result.minRay].point, in.origin);
+		float old_ln = len(old);
+
+		float oldP = dot(old, in.viewDir);
+		float newP = oldP * result.minDist / old_ln;
+
+		float d1 = in.grabDist;
+		float f = newP;
+		float d2 = f / (1 + (oldP - d1) / d1);
+
+		result.k = d2 / d1;
+		return result;
+	}
+
+	// Capture log: a FileHeader, then per solve a RecordHeader followed by rayCount Rays.
+	const uint32_t FILE_MAGIC = 0x564C5350; // "PSLV"
+	const uint32_t FILE_VERSION = 1;
+
+	struct FileHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+	};
+
+	struct RecordHeader
+	{
+		uint32_t rayCount;
+		Input input;
+		Result result;  // as computed in game, replays are compared against it
+		float castMs;   // time spent casting the rays
+	};
+
+	static_assert(sizeof(Ray) == 20, "capture layout changed, bump FILE_VERSION");
+	static_assert(sizeof(RecordHeader) == 52, "capture layout changed, bump FILE_VERSION");
+}
@@ -8,11 +8,33 @@
 #include <CryCore/Platform/platform_impl.inl>
 
 #include "Components/Player.h"
+#include "NetReplication.h"
+#include "TickScheduler.h"
+#include "SolveCapture.h"
+#include "GameLog.h"
+#include "ViewScalePolicy.h"
 
 CPlugin::~CPlugin()
 {
 	gEnv->pSystem->GetISystemEventDispatcher()->RemoveListener(this);
 
+	if (gEnv->pGameFramework)
+	{
+		gEnv->pGameFramework->RemoveNetworkedClientListener(*this);
+	}
+
+	if (gEnv->pConsole)
+	{
+		gEnv->pConsole->RemoveCommand("pl_netReport");
+	}
+
+	getTickScheduler().unregisterCVars();
+	getSolveCapture().unregisterCVars();
+	getViewScalePolicy().unregisterCVars();
+
+	getGameLog().stop();
+	getGameLog().unregisterCVars();
+
 	if (gEnv->pSchematyc)
 	{
 		gEnv->pSchematyc->GetEnvRegistry().DeregisterPackage(CPlugin::GetCID());
@@ -23,6 +45,14 @@ bool CPlugin::Initialize(SSystemGlobalEnvironment& env, const SSystemInitParams&
 {
 	gEnv->pSystem->GetISystemEventDispatcher()->RegisterListener(this,"CPlugin");
 
+	REGISTER_COMMAND("pl_netReport", &CPlugin::NetReportCommand, VF_NULL, "Prints estimated replication traffic since the last report, with measured channel bandwidth and ping");
+	getTickScheduler().registerCVars();
+	getSolveCapture().registerCVars();
+	getViewScalePolicy().registerCVars();
+
+	getGameLog().registerCVars();
+	getGameLog().start();
+
 	return true;
 }
 
@@ -31,6 +61,13 @@ void CPlugin::OnSystemEvent(ESystemEvent event, UINT_PTR wparam, UINT_PTR lparam
 	//CryLogAlways("MYDEBUG event happend %d", event);
 	switch (event)
 	{
+	case ESYSTEM_EVENT_GAME_POST_INIT:
+	{
+		gEnv->pGameFramework->AddNetworkedClientListener(*this);
+		getNetStats().reset();
+	}
+	break;
+
 	case ESYSTEM_EVENT_REGISTER_SCHEMATYC_ENV:
 	{
 		auto staticAutoRegisterLambda = [](Schematyc::IEnvRegistrar& registrar)
@@ -57,7 +94,26 @@ void CPlugin::OnSystemEvent(ESystemEvent event, UINT_PTR wparam, UINT_PTR lparam
 
 void CPlugin::MainUpdate(float frameRate)
 {
-	CryLogAlways("Main Update %f", frameRate);
+	GAME_LOG(Plugin, Debug, 1.f, "Main Update %f", frameRate);
+
+	getTickScheduler().update(gEnv->pTimer->GetFrameTime());
+}
+
+bool CPlugin::OnClientConnectionReceived(int channelId, bool bIsReset)
+{
+	stl::push_back_unique(getNetStats().channels, channelId);
+	return true;
+}
+
+void CPlugin::OnClientDisconnected(int channelId, EDisconnectionCause cause, const char* description, bool bKeepClient)
+{
+	stl::find_and_erase(getNetStats().channels, channelId);
+}
+
+void CPlugin::NetReportCommand(IConsoleCmdArgs* pArgs)
+{
+	getNetStats().report();
+	getNetStats().reset();
 }
 
 
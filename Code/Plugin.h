@@ -9,7 +9,7 @@
 class CPlugin 
 	: public Cry::IEnginePlugin
 	, public ISystemEventListener
-	//, public INetworkedClientListener
+	, public INetworkedClientListener
 {
 public:
 	CRYINTERFACE_SIMPLE(Cry::IEnginePlugin)
@@ -22,9 +22,12 @@ public:
 
 	virtual void MainUpdate(float frameRate) override;
 
-	//virtual void OnLocalClientDisconnected(EDisconnectionCause cause, const char* description) override {}
-	//virtual bool OnClientConnectionReceived(int channelId, bool bIsReset) override { return true; };
-	//virtual bool OnClientReadyForGameplay(int channelId, bool bIsReset) override { return true; };
-	//virtual void OnClientDisconnected(int channelId, EDisconnectionCause cause, const char* description, bool bKeepClient) override { };
-	//virtual bool OnClientTimingOut(int channelId, EDisconnectionCause cause, const char* description) override { return true; }
+	virtual void OnLocalClientDisconnected(EDisconnectionCause cause, const char* description) override {}
+	virtual bool OnClientConnectionReceived(int channelId, bool bIsReset) override;
+	virtual bool OnClientReadyForGameplay(int channelId, bool bIsReset) override { return true; };
+	virtual void OnClientDisconnected(int channelId, EDisconnectionCause cause, const char* description, bool bKeepClient) override;
+	virtual bool OnClientTimingOut(int channelId, EDisconnectionCause cause, const char* description) override { return true; }
+
+private:
+	static void NetReportCommand(IConsoleCmdArgs* pArgs);
 };
\ No newline at end of file
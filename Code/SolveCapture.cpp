@@ -0,0 +1,56 @@
+#include "StdAfx.h"
+#include "SolveCapture.h"
+
+#include <CrySystem/File/ICryPak.h>
+
+#include "GameLog.h"
+
+void SolveCapture::registerCVars()
+{
+	REGISTER_CVAR2("pl_solveCapture", &m_enabled, 0, VF_NULL, "Appends every forced perspective solve to the capture log");
+	m_path = REGISTER_STRING("pl_solveCapturePath", "%USER%/perspective_solves.bin", VF_NULL, "Capture log file, read when the log is first opened");
+}
+
+void SolveCapture::unregisterCVars()
+{
+	close();
+
+	if (gEnv->pConsole) {
+		gEnv->pConsole->UnregisterVariable("pl_solveCapture");
+		gEnv->pConsole->UnregisterVariable("pl_solveCapturePath");
+	}
+	m_path = nullptr;
+}
+
+void SolveCapture::write(const PerspectiveSolve::RecordHeader& header, const PerspectiveSolve::Ray* rays)
+{
+	if (!m_file) {
+		const char* path = m_path ? m_path->GetString() : "%USER%/perspective_solves.bin";
+
+		m_file = gEnv->pCryPak->FOpen(path, "ab");
+		if (!m_file) {
+			GAME_LOG(Player, Warning, 0.f, "Failed to open solve capture %s", path);
+			m_enabled = 0;
+			return;
+		}
+
+		if (gEnv->pCryPak->FGetSize(m_file) == 0) {
+			PerspectiveSolve::FileHeader fileHeader = { PerspectiveSolve::FILE_MAGIC, PerspectiveSolve::FILE_VERSION };
+			gEnv->pCryPak->FWrite(&fileHeader, sizeof(fileHeader), 1, m_file);
+		}
+	}
+
+	gEnv->pCryPak->FWrite(&header, sizeof(header), 1, m_file);
+	gEnv->pCryPak->FWrite(rays, sizeof(PerspectiveSolve::Ray), header.rayCount, m_file);
+
+	// Solves only happen on release, so every record is flushed to survive a crash.
+	gEnv->pCryPak->FFlush(m_file);
+}
+
+void SolveCapture::close()
+{
+	if (m_file) {
+		gEnv->pCryPak->FClose(m_file);
+		m_file = nullptr;
+	}
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "PerspectiveSolve.h"
+
+// Opt-in append-only log of forced perspective solves, read back by Tools/SolveReplay.
+class SolveCapture
+{
+	int m_enabled = 0;
+	ICVar* m_path = nullptr;
+	FILE* m_file = nullptr;
+
+public:
+	void registerCVars();
+	void unregisterCVars();
+
+	bool enabled() const { return m_enabled != 0; }
+	void write(const PerspectiveSolve::RecordHeader& header, const PerspectiveSolve::Ray* rays);
+	void close();
+};
+
+inline SolveCapture& getSolveCapture()
+{
+	static SolveCapture capture;
+	return capture;
+}
@@ -0,0 +1,44 @@
+#include "StdAfx.h"
+#include "TickScheduler.h"
+
+#include <CryGame/IGameFramework.h>
+
+#include "Components/Player.h"
+#include "Components/Teleport.h"
+
+void TickScheduler::registerCVars()
+{
+	REGISTER_CVAR2("pl_tickJobs", &m_jobs, 0, VF_NULL, "Portal checks run on the job system in chunks of this many portals, 0 runs them inline");
+	REGISTER_CVAR2("pl_tickDebug", &m_debug, 0, VF_NULL, "Draws the number of awake components per batch");
+}
+
+void TickScheduler::unregisterCVars()
+{
+	if (gEnv->pConsole) {
+		gEnv->pConsole->UnregisterVariable("pl_tickJobs");
+		gEnv->pConsole->UnregisterVariable("pl_tickDebug");
+	}
+}
+
+void TickScheduler::update(float delta)
+{
+	if (gEnv->IsEditing() || gEnv->pGameFramework->IsGamePaused())
+		return;
+
+	// Portal checks only read entity state, so they may run in parallel.
+	// Transits are applied afterwards on this thread.
+	auto detect = [](Teleport* teleport) { teleport->detectTransit(); };
+	if (m_jobs > 0)
+		teleports.forEachParallel(detect, (size_t)m_jobs);
+	else
+		teleports.forEach(detect);
+
+	teleports.tick(delta);
+	players.tick(delta);
+
+	if (m_debug) {
+		IPersistantDebug* db = gEnv->pGameFramework->GetIPersistantDebug();
+		db->Begin("TICK_SCHEDULER", true);
+		db->AddText(0, 20, 1.5f, ColorF(1, 1, 1), 1, "awake: %d players, %d teleports", (int)players.size(), (int)teleports.size());
+	}
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <CryThreading/IJobManager.h>
+
+class Player;
+class Teleport;
+
+// Components of one type that want a tick this frame, stored contiguously.
+// T::tick(float) returns false once the component has nothing to do and goes to sleep.
+template<class T>
+class TickBatch
+{
+	std::vector<T*> m_active;
+	std::vector<T*> m_woken; // woken while the batch was ticking
+	bool m_ticking = false;
+
+public:
+	void wake(T* component)
+	{
+		if (m_ticking)
+			stl::push_back_unique(m_woken, component);
+		else
+			stl::push_back_unique(m_active, component);
+	}
+
+	void remove(T* component)
+	{
+		stl::find_and_erase(m_active, component);
+		stl::find_and_erase(m_woken, component);
+	}
+
+	template<class F>
+	void forEach(F&& f)
+	{
+		for (T* component : m_active)
+			f(component);
+	}
+
+	// Splits the batch into chunks run on the job system, waits for all of them.
+	template<class F>
+	void forEachParallel(F&& f, size_t chunkSize)
+	{
+		const size_t count = m_active.size();
+		if (count <= chunkSize || !gEnv->pJobManager) {
+			forEach(f);
+			return;
+		}
+
+		const size_t chunks = (count + chunkSize - 1) / chunkSize;
+		std::vector<JobManager::SJobState> states(chunks);
+
+		for (size_t c = 0; c < chunks; c++) {
+			T* const* first = m_active.data() + c * chunkSize;
+			const size_t n = std::min(chunkSize, count - c * chunkSize);
+
+			gEnv->pJobManager->AddLambdaJob("TickBatch", [first, n, &f]() {
+				for (size_t i = 0; i < n; i++)
+					f(first[i]);
+			}, JobManager::eRegularPriority, &states[c]);
+		}
+
+		for (JobManager::SJobState& state : states)
+			gEnv->pJobManager->WaitForJob(state);
+	}
+
+	void tick(float delta)
+	{
+		m_ticking = true;
+		m_active.erase(std::remove_if(m_active.begin(), m_active.end(), [delta](T* component) {
+			return !component->tick(delta);
+		}), m_active.end());
+		m_ticking = false;
+
+		for (T* component : m_woken)
+			stl::push_back_unique(m_active, component);
+		m_woken.clear();
+	}
+
+	size_t size() const { return m_active.size(); }
+};
+
+// Gameplay updates driven from CPlugin::MainUpdate instead of per-entity Update events.
+class TickScheduler
+{
+	int m_jobs = 0;
+	int m_debug = 0;
+
+public:
+	TickBatch<Player> players;
+	TickBatch<Teleport> teleports;
+
+	void registerCVars();
+	void unregisterCVars();
+
+	void update(float delta);
+	void remove(Player* player) { players.remove(player); }
+	void remove(Teleport* teleport) { teleports.remove(teleport); }
+};
+
+inline TickScheduler& getTickScheduler()
+{
+	static TickScheduler scheduler;
+	return scheduler;
+}
@@ -0,0 +1,85 @@
+#include "StdAfx.h"
+#include "ViewScalePolicy.h"
+
+void ViewScalePolicy::registerCVars()
+{
+	REGISTER_CVAR2("pl_viewScale", &m_enabled, 1, VF_NULL, "Scales view distance, LOD ratio and the player camera near plane with the player");
+	REGISTER_CVAR2("pl_viewScaleHysteresis", &m_hysteresis, 0.35f, VF_NULL, "Octaves the player scale must drift before the view settings follow");
+	REGISTER_CVAR2("pl_viewScaleMin", &m_minScale, 0.0625f, VF_NULL, "Player scale below which the view settings stop shrinking");
+	REGISTER_CVAR2("pl_viewScaleMax", &m_maxScale, 16.f, VF_NULL, "Player scale above which the view settings stop growing");
+}
+
+void ViewScalePolicy::unregisterCVars()
+{
+	reset();
+
+	if (gEnv->pConsole) {
+		gEnv->pConsole->UnregisterVariable("pl_viewScale");
+		gEnv->pConsole->UnregisterVariable("pl_viewScaleHysteresis");
+		gEnv->pConsole->UnregisterVariable("pl_viewScaleMin");
+		gEnv->pConsole->UnregisterVariable("pl_viewScaleMax");
+	}
+}
+
+void ViewScalePolicy::update(float scale, bool force)
+{
+	if (!m_enabled || scale <= 0.f) {
+		reset();
+		return;
+	}
+
+	const float level = log2f(CLAMP(scale, m_minScale, m_maxScale));
+
+	// Resizes are blended and the player may hover around a size, only settle on real changes.
+	if (m_active && !force && fabsf(level - m_applied) <= m_hysteresis)
+		return;
+
+	m_applied = level;
+	m_active = true;
+	set(exp2f(level));
+}
+
+void ViewScalePolicy::reset()
+{
+	if (!m_active)
+		return;
+
+	set(1.f);
+	m_active = false;
+
+	// Changes made while the policy is off become the baseline when it turns on again.
+	for (Setting& setting : m_settings)
+		setting.captured = false;
+}
+
+void ViewScalePolicy::set(float scale)
+{
+	if (gEnv->p3DEngine)
+		gEnv->p3DEngine->SetMaxViewDistanceScale(scale);
+
+	m_nearPlaneFactor = scale;
+
+	if (!gEnv->pConsole)
+		return;
+
+	for (Setting& setting : m_settings) {
+		ICVar* cvar = gEnv->pConsole->GetCVar(setting.name);
+		if (!cvar)
+			continue;
+
+		if (!setting.captured) {
+			setting.base = cvar->GetFVal();
+			setting.captured = true;
+		}
+
+		const float exponent = scale < 1.f ? setting.shrink : setting.grow;
+		float value = setting.base * powf(scale, exponent);
+		// Never clamp a baseline the project chose outside of the range.
+		value = CLAMP(value, std::min(setting.minValue, setting.base), std::max(setting.maxValue, setting.base));
+
+		if (cvar->GetType() == ECVarType::Int)
+			cvar->Set((int)(value + 0.5f));
+		else
+			cvar->Set(value);
+	}
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+// Scales view distance, LOD and culling with the player so render and streaming load
+// follow what the player can see at their size.
+// Values set by the project or the user are kept as the scale 1 baseline and restored on reset.
+class ViewScalePolicy
+{
+	struct Setting
+	{
+		const char* name;
+		float shrink;     // value = base * scale^exponent, exponent below scale 1
+		float grow;       // and above it
+		float minValue;
+		float maxValue;
+		float base = 0.f;
+		bool captured = false;
+	};
+
+	// A small player has everything up close, so distant objects and LODs go early.
+	// A giant sees further but small props and fine LODs stop mattering.
+	Setting m_settings[4] = {
+		{ "e_ViewDistMin", 1.f, 1.f, 0.f, 1000.f },
+		{ "e_ViewDistRatio", 1.f, 0.f, 5.f, 1000.f },
+		{ "e_ViewDistRatioDetail", 1.f, -1.f, 5.f, 1000.f },
+		{ "e_LodRatio", 1.f, -0.5f, 0.5f, 100.f },
+	};
+
+	int m_enabled = 1;
+	float m_hysteresis = 0.35f; // in octaves of scale
+	float m_minScale = 0.0625f;
+	float m_maxScale = 16.f;
+
+	float m_applied = 0.f;      // log2 of the scale in effect, valid when m_active
+	bool m_active = false;
+
+	// The camera component frustum uses its own Near Plane property, not cl_DefaultNearPlane,
+	// so the near plane is handed to the player camera instead of set through a cvar.
+	float m_nearPlaneFactor = 1.f;
+
+	void set(float scale);
+
+public:
+	void registerCVars();
+	void unregisterCVars();
+
+	// Called with the viewing player's scale, changes settle once the scale is outside the hysteresis band.
+	void update(float scale, bool force = false);
+	void reset();
+
+	// Near plane for the scale in effect, base is the camera's own value at scale 1.
+	float nearPlane(float base) const
+	{
+		return CLAMP(base * m_nearPlaneFactor, std::min(0.005f, base), std::max(0.5f, base));
+	}
+};
+
+inline ViewScalePolicy& getViewScalePolicy()
+{
+	static ViewScalePolicy policy;
+	return policy;
+}
@@ -0,0 +1,253 @@
+// Replays a forced perspective capture log written with pl_solveCapture.
+//
+//   SolveReplay <capture.bin> [--record <index>] [--slowest <count>] [--bench <iterations>]
+//
+// Every record is solved again and compared with the result the game got.
+
+#include "PerspectiveSolve.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace PerspectiveSolve;
+
+class MappedFile
+{
+	const uint8_t* m_data = nullptr;
+	size_t m_size = 0;
+#ifdef _WIN32
+	HANDLE m_file = INVALID_HANDLE_VALUE;
+	HANDLE m_mapping = nullptr;
+#endif
+
+public:
+	explicit MappedFile(const char* path)
+	{
+#ifdef _WIN32
+		m_file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (m_file == INVALID_HANDLE_VALUE)
+			return;
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0)
+			return;
+
+		m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!m_mapping)
+			return;
+
+		m_data = (const uint8_t*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+		m_size = m_data ? (size_t)size.QuadPart : 0;
+#else
+		int fd = open(path, O_RDONLY);
+		if (fd < 0)
+			return;
+
+		struct stat st;
+		if (fstat(fd, &st) == 0 && st.st_size > 0) {
+			void* data = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (data != MAP_FAILED) {
+				m_data = (const uint8_t*)data;
+				m_size = (size_t)st.st_size;
+			}
+		}
+		close(fd);
+#endif
+	}
+
+	~MappedFile()
+	{
+#ifdef _WIN32
+		if (m_data)
+			UnmapViewOfFile(m_data);
+		if (m_mapping)
+			CloseHandle(m_mapping);
+		if (m_file != INVALID_HANDLE_VALUE)
+			CloseHandle(m_file);
+#else
+		if (m_data)
+			munmap((void*)m_data, m_size);
+#endif
+	}
+
+	const uint8_t* data() const { return m_data; }
+	size_t size() const { return m_size; }
+};
+
+// Records point straight into the mapping, nothing is copied.
+struct Record
+{
+	RecordHeader header;
+	const Ray* rays;
+};
+
+static bool sameResult(const Result& a, const Result& b)
+{
+	return a.minRay == b.minRay && fabsf(a.k - b.k) <= 1e-5f * std::max(fabsf(a.k), 1.f);
+}
+
+static void printRecord(size_t index, const Record& record)
+{
+	const RecordHeader& h = record.header;
+	Result replayed = solve(h.input, record.rays, h.rayCount);
+
+	printf("record %zu: %u rays, cast %.3f ms\n", index, h.rayCount, h.castMs);
+	printf("  origin   %f %f %f\n", h.input.origin.x, h.input.origin.y, h.input.origin.z);
+	printf("  viewDir  %f %f %f\n", h.input.viewDir.x, h.input.viewDir.y, h.input.viewDir.z);
+	printf("  grabDist %f, wallMargin %f\n", h.input.grabDist, h.input.wallMargin);
+	printf("  game     minRay %d k %f\n", h.result.minRay, h.result.k);
+	printf("  replay   minRay %d k %f\n", replayed.minRay, replayed.k);
+
+	for (uint32_t i = 0; i < h.rayCount; i++) {
+		const Ray& ray = record.rays[i];
+		printf("  %4u %c hops %u point %f %f %f hit %f\n", i, (ray.flags & RAY_HIT) ? 'H' : '-', ray.flags >> 8,
+			ray.point.x, ray.point.y, ray.point.z, ray.hitDist);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2) {
+		fprintf(stderr, "usage: %s <capture.bin> [--record <index>] [--slowest <count>] [--bench <iterations>]\n", argv[0]);
+		return 2;
+	}
+
+	long recordIndex = -1;
+	long slowest = 0;
+	long benchIterations = 0;
+
+	for (int i = 2; i + 1 < argc; i += 2) {
+		if (!strcmp(argv[i], "--record"))
+			recordIndex = atol(argv[i + 1]);
+		else if (!strcmp(argv[i], "--slowest"))
+			slowest = atol(argv[i + 1]);
+		else if (!strcmp(argv[i], "--bench"))
+			benchIterations = atol(argv[i + 1]);
+		else {
+			fprintf(stderr, "unknown option %s\n", argv[i]);
+			return 2;
+		}
+	}
+
+	MappedFile file(argv[1]);
+	if (!file.data()) {
+		fprintf(stderr, "cannot map %s\n", argv[1]);
+		return 1;
+	}
+
+	FileHeader fileHeader;
+	if (file.size() < sizeof(fileHeader)) {
+		fprintf(stderr, "%s is too short\n", argv[1]);
+		return 1;
+	}
+
+	memcpy(&fileHeader, file.data(), sizeof(fileHeader));
+	if (fileHeader.magic != FILE_MAGIC || fileHeader.version != FILE_VERSION) {
+		fprintf(stderr, "%s is not a version %u capture\n", argv[1], FILE_VERSION);
+		return 1;
+	}
+
+	std::vector<Record> records;
+	size_t offset = sizeof(fileHeader);
+
+	while (offset + sizeof(RecordHeader) <= file.size()) {
+		Record record;
+		memcpy(&record.header, file.data() + offset, sizeof(RecordHeader));
+		offset += sizeof(RecordHeader);
+
+		const size_t raysSize = (size_t)record.header.rayCount * sizeof(Ray);
+		if (offset + raysSize > file.size()) {
+			fprintf(stderr, "truncated record %zu ignored\n", records.size());
+			break;
+		}
+
+		record.rays = (const Ray*)(file.data() + offset);
+		offset += raysSize;
+		records.push_back(record);
+	}
+
+	if (recordIndex >= 0) {
+		if ((size_t)recordIndex >= records.size()) {
+			fprintf(stderr, "record %ld out of range, %zu records\n", recordIndex, records.size());
+			return 1;
+		}
+		printRecord((size_t)recordIndex, records[recordIndex]);
+		return 0;
+	}
+
+	size_t rays = 0;
+	size_t unhit = 0;
+	size_t mismatches = 0;
+	float castMs = 0;
+	float maxCastMs = 0;
+	float minK = INFINITY;
+	float maxK = 0;
+
+	for (size_t i = 0; i < records.size(); i++) {
+		const RecordHeader& h = records[i].header;
+		Result replayed = solve(h.input, records[i].rays, h.rayCount);
+
+		rays += h.rayCount;
+		castMs += h.castMs;
+		maxCastMs = std::max(maxCastMs, h.castMs);
+
+		if (replayed.minRay == -1) {
+			unhit++;
+		}
+		else {
+			minK = std::min(minK, replayed.k);
+			maxK = std::max(maxK, replayed.k);
+		}
+
+		if (!sameResult(replayed, h.result)) {
+			if (mismatches < 10)
+				printf("record %zu: game k %f ray %d, replay k %f ray %d\n", i, h.result.k, h.result.minRay, replayed.k, replayed.minRay);
+			mismatches++;
+		}
+	}
+
+	const size_t count = records.size();
+	printf("%zu solves, %zu rays (%.1f per solve)\n", count, rays, count ? (double)rays / count : 0.0);
+	printf("cast time: %.3f ms avg, %.3f ms max\n", count ? castMs / count : 0.f, maxCastMs);
+	if (count > unhit)
+		printf("k: %f .. %f, %zu solves without a hit\n", minK, maxK, unhit);
+	printf("%zu replay mismatches\n", mismatches);
+
+	if (slowest > 0) {
+		std::vector<size_t> order(count);
+		for (size_t i = 0; i < count; i++)
+			order[i] = i;
+
+		std::sort(order.begin(), order.end(), [&records](size_t a, size_t b) { return records[a].header.castMs > records[b].header.castMs; });
+
+		for (size_t i = 0; i < std::min((size_t)slowest, count); i++)
+			printf("slow: record %zu, %u rays, %.3f ms\n", order[i], records[order[i]].header.rayCount, records[order[i]].header.castMs);
+	}
+
+	if (benchIterations > 0 && count > 0) {
+		volatile float sink = 0;
+		auto start = std::chrono::steady_clock::now();
+
+		for (long it = 0; it < benchIterations; it++) {
+			for (const Record& record : records)
+				sink = sink + solve(record.header.input, record.rays, record.header.rayCount).k;
+		}
+
+		double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+		printf("bench: %.1f ns per solve over %ld iterations\n", ns / ((double)benchIterations * count), benchIterations);
+	}
+
+	return mismatches ? 3 : 0;
+}